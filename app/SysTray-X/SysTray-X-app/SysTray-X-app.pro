@@ -162,6 +162,7 @@ win32: {
 
 SOURCES += \
         debugwidget.cpp \
+        logger.cpp \
         main.cpp \
         nativeeventfilterbase.cpp \
         systrayxlink.cpp \
@@ -170,6 +171,7 @@ SOURCES += \
         preferencesdialog.cpp \
         preferences.cpp \
         shortcut.cpp \
+        tracer.cpp \
         windowctrl.cpp
 
 unix: {
@@ -191,6 +193,7 @@ SOURCES += \
 HEADERS += \
         debug.h \
         debugwidget.h \
+        logger.h \
         nativeeventfilterbase.h \
         preferencesdialog.h \
         preferences.h \
@@ -198,6 +201,7 @@ HEADERS += \
         systrayxicon.h \
         systrayx.h \
         shortcut.h \
+        tracer.h \
         windowctrl.h
 
 unix: {
@@ -5,6 +5,7 @@
  *	Local includes
  */
 #include "preferences.h"
+#include "logger.h"
 
 /*
  *	System includes
@@ -13,6 +14,7 @@
 /*
  *	Qt includes
  */
+#include <QTimer>
 
 
 /*
@@ -34,6 +36,17 @@ DebugWidget::DebugWidget( Preferences* pref, QWidget* parent ) : QWidget( parent
     connect( m_ui->test2PushButton, &QPushButton::clicked, this, &DebugWidget::slotHandleTest2Button);
     connect( m_ui->test3PushButton, &QPushButton::clicked, this, &DebugWidget::slotHandleTest3Button);
     connect( m_ui->test4PushButton, &QPushButton::clicked, this, &DebugWidget::slotHandleTest4Button);
+    connect( m_ui->statsPushButton, &QPushButton::clicked, this, &DebugWidget::slotHandleStatsButton);
+
+    /*
+     *  Show the log from the buffer, keep as many lines as it holds
+     */
+    m_ui->textEdit->setMaximumBlockCount( LOG_RING_SIZE );
+
+    m_log_next = Logger::tail();
+
+    m_log_timer = new QTimer( this );
+    connect( m_log_timer, &QTimer::timeout, this, &DebugWidget::slotLogUpdate );
 }
 
 
@@ -51,6 +64,30 @@ void    DebugWidget::changeEvent( QEvent* event )
 }
 
 
+/*
+ *  Start following the log when shown
+ */
+void    DebugWidget::showEvent( QShowEvent* event )
+{
+    QWidget::showEvent( event );
+
+    slotLogUpdate();
+
+    m_log_timer->start( LOG_VIEW_INTERVAL );
+}
+
+
+/*
+ *  Stop following the log when hidden
+ */
+void    DebugWidget::hideEvent( QHideEvent* event )
+{
+    m_log_timer->stop();
+
+    QWidget::hideEvent( event );
+}
+
+
 /*
  *  Set the number of unread/new mails
  */
@@ -70,6 +107,18 @@ void    DebugWidget::slotDebugChange()
 }
 
 
+/*
+ *  Handle a preferences change set
+ */
+void    DebugWidget::slotPreferencesChanged( Preferences::ChangeSet changes )
+{
+    if( changes.testFlag( Preferences::CHANGE_DEBUG ) )
+    {
+        slotDebugChange();
+    }
+}
+
+
 /*
  *  Handle unread mail signal
  */
@@ -116,9 +165,22 @@ void    DebugWidget::slotHandleTest4Button()
 
 
 /*
- *  Handle console signal
+ *  Handle stats button click
  */
-void    DebugWidget::slotConsole( QString message )
+void    DebugWidget::slotHandleStatsButton()
 {
-    m_ui->textEdit->append( message );
+    emit signalStatsButtonClicked();
+}
+
+
+/*
+ *  Show the new log entries
+ */
+void    DebugWidget::slotLogUpdate()
+{
+    QStringList lines = Logger::readLines( m_log_next );
+    if( !lines.isEmpty() )
+    {
+        m_ui->textEdit->appendPlainText( lines.join( "\n" ) );
+    }
 }
@@ -4,16 +4,22 @@
 /*
  *	Local includes
  */
+#include "preferences.h"
 
 /*
  *	Qt includes
  */
 #include <QWidget>
 
+/*
+ *  Log view update interval in ms, only while visible
+ */
+#define LOG_VIEW_INTERVAL   250
+
 /*
  *	Predefines
  */
-class Preferences;
+class QTimer;
 
 /*
  *  Namespace
@@ -45,6 +51,20 @@ class DebugWidget : public QWidget
          */
         void    changeEvent( QEvent *event );
 
+        /**
+         * @brief showEvent. Override the show event, start following the log.
+         *
+         *  @param event    The event.
+         */
+        void    showEvent( QShowEvent* event );
+
+        /**
+         * @brief hideEvent. Override the hide event, stop following the log.
+         *
+         *  @param event    The event.
+         */
+        void    hideEvent( QHideEvent* event );
+
         /**
          * @brief setMailCount. Set the number of unread/new mails.
          *
@@ -75,6 +95,11 @@ class DebugWidget : public QWidget
          */
         void    signalTest4ButtonClicked();
 
+        /**
+         * @brief signalStatsButtonClicked. Signal the stats button was clicked.
+         */
+        void    signalStatsButtonClicked();
+
     public slots:
 
         /**
@@ -82,6 +107,13 @@ class DebugWidget : public QWidget
          */
         void    slotDebugChange();
 
+        /**
+         * @brief slotPreferencesChanged. Slot for handling a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         */
+        void    slotPreferencesChanged( Preferences::ChangeSet changes );
+
         /**
          * @brief slotMailCount. Slot for handling unread/new mail signals.
          *
@@ -111,11 +143,16 @@ class DebugWidget : public QWidget
         void    slotHandleTest4Button();
 
         /**
-         * @brief slotConsole. Handle console signal.
-         *
-         *  @param message      The message for the console.
+         * @brief slotHandleStatsButton. Handle a click on the stats button.
          */
-        void    slotConsole( QString message );
+        void    slotHandleStatsButton();
+
+    private slots:
+
+        /**
+         * @brief slotLogUpdate. Show the new log entries.
+         */
+        void    slotLogUpdate();
 
     private:
 
@@ -128,6 +165,16 @@ class DebugWidget : public QWidget
          * @brief m_pref. Pointer to ther preferences.
          */
         Preferences*    m_pref;
+
+        /**
+         * @brief m_log_timer. Log view update timer.
+         */
+        QTimer* m_log_timer;
+
+        /**
+         * @brief m_log_next. Sequence number of the next log entry to show.
+         */
+        quint64 m_log_next;
 };
 
 #endif // DEBUGWIDGET_H
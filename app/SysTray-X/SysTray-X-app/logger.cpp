@@ -0,0 +1,330 @@
+#include "logger.h"
+
+/*
+ *	Local includes
+ */
+
+/*
+ *	System includes
+ */
+#include <string.h>
+
+/*
+ *	Qt includes
+ */
+#include <QFile>
+#include <QTimer>
+#include <QThread>
+#include <QDateTime>
+
+
+/*
+ *  Constants
+ */
+const QStringList   Logger::LevelString = {
+    "debug",
+    "info",
+    "warning",
+    "error",
+    "off"
+};
+
+
+/*
+ *  Storage, only warnings and errors until told otherwise
+ */
+std::atomic< int >  Logger::m_level( Logger::LEVEL_WARNING );
+std::atomic< quint64 >  Logger::m_head( 0 );
+Logger::Slot    Logger::m_ring[ LOG_RING_SIZE ];
+
+
+/*
+ *  Set the lowest level to be logged
+ */
+void    Logger::setLevel( Level level )
+{
+    m_level.store( level, std::memory_order_relaxed );
+}
+
+
+/*
+ *  Log a message
+ */
+void    Logger::log( Level level, const QString& message )
+{
+    if( !isEnabled( level ) )
+    {
+        return;
+    }
+
+    /*
+     *  Claim a slot, the oldest entry is overwritten
+     */
+    quint64 sequence = m_head.fetch_add( 1, std::memory_order_relaxed );
+    Slot& slot = m_ring[ sequence & ( LOG_RING_SIZE - 1 ) ];
+
+    slot.stamp.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slot.time = QDateTime::currentMSecsSinceEpoch();
+    slot.level = level;
+
+    /*
+     *  Cut too long messages on a character boundary
+     */
+    QByteArray text = message.toUtf8();
+    int length = qMin( text.length(), LOG_TEXT_SIZE - 1 );
+    while( length > 0 && length < text.length() && ( text.at( length ) & 0xC0 ) == 0x80 )
+    {
+        --length;
+    }
+
+    memcpy( slot.text, text.constData(), length );
+    slot.text[ length ] = '\0';
+
+    /*
+     *  Publish the entry
+     */
+    slot.stamp.store( sequence + 1, std::memory_order_release );
+}
+
+
+/*
+ *  Get the sequence number of the next entry
+ */
+quint64 Logger::head()
+{
+    return m_head.load( std::memory_order_acquire );
+}
+
+
+/*
+ *  Get the sequence number of the oldest entry still in the buffer
+ */
+quint64 Logger::tail()
+{
+    quint64 head = m_head.load( std::memory_order_acquire );
+
+    return head > LOG_RING_SIZE ? head - LOG_RING_SIZE : 0;
+}
+
+
+/*
+ *  Read an entry
+ */
+bool    Logger::read( quint64 sequence, Entry& entry )
+{
+    const Slot& slot = m_ring[ sequence & ( LOG_RING_SIZE - 1 ) ];
+
+    if( slot.stamp.load( std::memory_order_acquire ) != sequence + 1 )
+    {
+        return false;
+    }
+
+    qint64 time = slot.time;
+    Level level = slot.level;
+    char text[ LOG_TEXT_SIZE ];
+    memcpy( text, slot.text, LOG_TEXT_SIZE );
+
+    /*
+     *  Overwritten while copying?
+     */
+    std::atomic_thread_fence( std::memory_order_acquire );
+    if( slot.stamp.load( std::memory_order_relaxed ) != sequence + 1 )
+    {
+        return false;
+    }
+
+    text[ LOG_TEXT_SIZE - 1 ] = '\0';
+
+    entry.sequence = sequence;
+    entry.time = time;
+    entry.level = level;
+    entry.text = QString::fromUtf8( text );
+
+    return true;
+}
+
+
+/*
+ *  Format an entry for display
+ */
+QString Logger::format( const Entry& entry )
+{
+    return QString( "%1 [%2] %3" ).arg(
+                QDateTime::fromMSecsSinceEpoch( entry.time ).toString( "hh:mm:ss.zzz" ),
+                LevelString.at( entry.level ),
+                entry.text );
+}
+
+
+/*
+ *  Read and format the entries from a position on
+ */
+QStringList Logger::readLines( quint64& next )
+{
+    QStringList lines;
+
+    quint64 lost = 0;
+    quint64 head = Logger::head();
+    while( next < head )
+    {
+        /*
+         *  Skip the entries overwritten before they were read in one step
+         */
+        quint64 oldest = tail();
+        if( next < oldest )
+        {
+            lost += oldest - next;
+            next = oldest;
+
+            continue;
+        }
+
+        Entry entry;
+        if( read( next, entry ) )
+        {
+            if( lost > 0 )
+            {
+                lines.append( QString( "... %1 entries lost" ).arg( lost ) );
+                lost = 0;
+            }
+
+            lines.append( format( entry ) );
+        }
+        else
+        if( next < tail() )
+        {
+            /*
+             *  Overwritten while reading, skipped above
+             */
+            continue;
+        }
+        else
+        {
+            /*
+             *  Still being written, next time
+             */
+            break;
+        }
+
+        ++next;
+    }
+
+    if( lost > 0 )
+    {
+        lines.append( QString( "... %1 entries lost" ).arg( lost ) );
+    }
+
+    return lines;
+}
+
+
+/*
+ *  Constructor
+ */
+LoggerFileWriter::LoggerFileWriter( const QString& path )
+{
+    m_path = path;
+    m_file = nullptr;
+    m_timer = nullptr;
+
+    /*
+     *  Include what is still in the buffer
+     */
+    m_next = Logger::tail();
+}
+
+
+/*
+ *  Destructor
+ */
+LoggerFileWriter::~LoggerFileWriter()
+{
+    /*
+     *  Write the remaining entries
+     */
+    slotWrite();
+
+    if( m_file )
+    {
+        m_file->close();
+    }
+}
+
+
+/*
+ *  Open the file and start writing
+ */
+void    LoggerFileWriter::slotStart()
+{
+    m_file = new QFile( m_path, this );
+    if( !m_file->open( QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text ) )
+    {
+        delete m_file;
+        m_file = nullptr;
+
+        LOG_WARNING( QString( "Cannot open log file: %1" ).arg( m_path ) );
+
+        return;
+    }
+
+    m_timer = new QTimer( this );
+    connect( m_timer, &QTimer::timeout, this, &LoggerFileWriter::slotWrite );
+    m_timer->start( LOG_SINK_INTERVAL );
+}
+
+
+/*
+ *  Write the new entries
+ */
+void    LoggerFileWriter::slotWrite()
+{
+    if( !m_file )
+    {
+        return;
+    }
+
+    QStringList lines = Logger::readLines( m_next );
+    if( !lines.isEmpty() )
+    {
+        lines.append( QString() );
+
+        m_file->write( lines.join( "\n" ).toUtf8() );
+        m_file->flush();
+    }
+}
+
+
+/*
+ *  Constructor
+ */
+LoggerFileSink::LoggerFileSink( const QString& path, QObject* parent ) : QObject( parent )
+{
+    /*
+     *  Setup the writer thread
+     */
+    m_thread = new QThread( this );
+    m_thread->setObjectName( "Log writer" );
+
+    LoggerFileWriter* writer = new LoggerFileWriter( path );
+    writer->moveToThread( m_thread );
+
+    connect( m_thread, &QThread::finished, writer, &QObject::deleteLater );
+    connect( m_thread, &QThread::started, writer, &LoggerFileWriter::slotStart );
+
+    m_thread->start();
+}
+
+
+/*
+ *  Destructor
+ */
+LoggerFileSink::~LoggerFileSink()
+{
+    /*
+     *  Stop the writer thread
+     */
+    m_thread->quit();
+    m_thread->wait();
+}
@@ -0,0 +1,273 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/*
+ *	Local includes
+ */
+
+/*
+ *	Qt includes
+ */
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+/*
+ *  System includes
+ */
+#include <atomic>
+
+/*
+ *  Ring buffer size in entries, a power of 2
+ */
+#define LOG_RING_SIZE       1024
+
+/*
+ *  Maximum message length in bytes (UTF-8), longer messages are cut
+ */
+#define LOG_TEXT_SIZE       240
+
+/*
+ *  File sink write interval in ms
+ */
+#define LOG_SINK_INTERVAL   250
+
+/*
+ *  Environment variable with the path of the log file
+ */
+#define LOG_FILE_ENV        "SYSTRAYX_LOG_FILE"
+
+/*
+ *  Log a message, the message is only built when the level is enabled
+ */
+#define LOG_DEBUG( message )    do { if( Logger::isEnabled( Logger::LEVEL_DEBUG ) ) Logger::log( Logger::LEVEL_DEBUG, message ); } while( 0 )
+#define LOG_INFO( message )     do { if( Logger::isEnabled( Logger::LEVEL_INFO ) ) Logger::log( Logger::LEVEL_INFO, message ); } while( 0 )
+#define LOG_WARNING( message )  do { if( Logger::isEnabled( Logger::LEVEL_WARNING ) ) Logger::log( Logger::LEVEL_WARNING, message ); } while( 0 )
+#define LOG_ERROR( message )    do { if( Logger::isEnabled( Logger::LEVEL_ERROR ) ) Logger::log( Logger::LEVEL_ERROR, message ); } while( 0 )
+
+/*
+ *	Predefines
+ */
+class QFile;
+class QTimer;
+class QThread;
+
+
+/**
+ * @brief The Logger class. Levelled logging into a fixed size lock-free ring buffer.
+ *
+ *  Any thread can log. Writers never block, the oldest entries are overwritten.
+ *  Readers keep their own position and detect the entries they missed.
+ */
+class Logger
+{
+    public:
+
+        /*
+         *  Log levels
+         */
+        enum Level {
+            LEVEL_DEBUG = 0,
+            LEVEL_INFO,
+            LEVEL_WARNING,
+            LEVEL_ERROR,
+            LEVEL_OFF
+        };
+
+        /*
+         *  Level names
+         */
+        static const QStringList LevelString;
+
+        /**
+         * @brief The Entry struct. A copy of a log entry.
+         */
+        struct Entry {
+            quint64 sequence;
+            qint64  time;
+            Level   level;
+            QString text;
+        };
+
+    public:
+
+        /**
+         * @brief setLevel. Set the lowest level to be logged.
+         *
+         *  @param level    The level.
+         */
+        static void setLevel( Level level );
+
+        /**
+         * @brief isEnabled. Is the level logged.
+         *
+         *  @param level    The level.
+         *
+         *  @return     State.
+         */
+        static bool isEnabled( Level level )
+        {
+            return level >= m_level.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * @brief log. Log a message.
+         *
+         *  @param level    The level.
+         *  @param message  The message.
+         */
+        static void log( Level level, const QString& message );
+
+        /**
+         * @brief head. Get the sequence number of the next entry.
+         *
+         *  @return     The sequence number.
+         */
+        static quint64 head();
+
+        /**
+         * @brief tail. Get the sequence number of the oldest entry still in the buffer.
+         *
+         *  @return     The sequence number.
+         */
+        static quint64 tail();
+
+        /**
+         * @brief read. Read an entry.
+         *
+         *  @param sequence     The sequence number of the entry.
+         *  @param entry        Storage for the entry.
+         *
+         *  @return     False if the entry has been overwritten or is still being written.
+         */
+        static bool read( quint64 sequence, Entry& entry );
+
+        /**
+         * @brief format. Format an entry for display.
+         *
+         *  @param entry    The entry.
+         *
+         *  @return     The line.
+         */
+        static QString format( const Entry& entry );
+
+        /**
+         * @brief readLines. Read and format the entries from a position on.
+         *
+         *  @param next     Sequence number of the next entry to read, advanced past the read entries.
+         *
+         *  @return     The lines, overwritten entries are reported as lost.
+         */
+        static QStringList readLines( quint64& next );
+
+    private:
+
+        /**
+         * @brief The Slot struct. A ring buffer slot.
+         *
+         *  The stamp is the sequence number + 1 of the entry in the slot, 0 while it is written.
+         */
+        struct Slot {
+            std::atomic< quint64 > stamp;
+            qint64  time;
+            Level   level;
+            char    text[ LOG_TEXT_SIZE ];
+        };
+
+        /**
+         * @brief m_level. The lowest level logged.
+         */
+        static std::atomic< int > m_level;
+
+        /**
+         * @brief m_head. Sequence number of the next entry.
+         */
+        static std::atomic< quint64 > m_head;
+
+        /**
+         * @brief m_ring. The ring buffer.
+         */
+        static Slot m_ring[ LOG_RING_SIZE ];
+};
+
+
+/**
+ * @brief The LoggerFileWriter class. Writes the log entries to a file in its own thread.
+ */
+class LoggerFileWriter : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        /**
+         * @brief LoggerFileWriter. Constructor, destructor.
+         *
+         *  @param path     Path of the log file.
+         */
+        explicit LoggerFileWriter( const QString& path );
+        ~LoggerFileWriter();
+
+    public slots:
+
+        /**
+         * @brief slotStart. Open the file and start writing.
+         */
+        void    slotStart();
+
+        /**
+         * @brief slotWrite. Write the new entries.
+         */
+        void    slotWrite();
+
+    private:
+
+        /**
+         * @brief m_path. Path of the log file.
+         */
+        QString m_path;
+
+        /**
+         * @brief m_file. The log file.
+         */
+        QFile*  m_file;
+
+        /**
+         * @brief m_timer. Write timer.
+         */
+        QTimer* m_timer;
+
+        /**
+         * @brief m_next. Sequence number of the next entry to write.
+         */
+        quint64 m_next;
+};
+
+
+/**
+ * @brief The LoggerFileSink class. Asynchronous file sink for the log.
+ */
+class LoggerFileSink : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        /**
+         * @brief LoggerFileSink. Constructor, destructor.
+         *
+         *  @param path     Path of the log file.
+         *  @param parent   My parent.
+         */
+        explicit LoggerFileSink( const QString& path, QObject* parent = nullptr );
+        ~LoggerFileSink();
+
+    private:
+
+        /**
+         * @brief m_thread. The writer thread.
+         */
+        QThread*    m_thread;
+};
+
+#endif // LOGGER_H
@@ -2,18 +2,47 @@
  *	Local includes
  */
 #include "systrayx.h"
+#include "tracer.h"
 
 /*
  *	Qt includes
  */
 #include <QApplication>
+#include <QThread>
 
 int main( int argc, char *argv[] )
 {
+    /*
+     *  Start the trace when requested
+     */
+    QString trace_file = QString::fromLocal8Bit( qgetenv( TRACE_ENV ) );
+    for( int i = 1 ; i < argc ; ++i )
+    {
+        QString argument = QString::fromLocal8Bit( argv[ i ] );
+        if( argument.startsWith( TRACE_ARGUMENT ) )
+        {
+            trace_file = argument.mid( QString( TRACE_ARGUMENT ).length() );
+        }
+    }
+
+    if( !trace_file.isEmpty() )
+    {
+        Tracer::start( trace_file );
+    }
+
     QApplication a( argc, argv );
     a.setQuitOnLastWindowClosed( false );
 
+    QThread::currentThread()->setObjectName( "Main" );
+
     SysTrayX systrayx;
 
-    return a.exec();
+    int result = a.exec();
+
+    /*
+     *  Write the trace
+     */
+    Tracer::stop();
+
+    return result;
 }
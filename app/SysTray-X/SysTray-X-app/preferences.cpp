@@ -3,6 +3,8 @@
 /*
  *	Local includes
  */
+#include "logger.h"
+#include "tracer.h"
 
 
 /*
@@ -13,6 +15,13 @@
  *	Qt includes
  */
 #include <QGuiApplication>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
 
 
 /*
@@ -97,6 +106,11 @@ Preferences::Preferences( QObject *parent ) : QObject( parent )
 
     m_show_hide_shortcut = QKeySequence();
 
+    m_snapshot_hash = QByteArray();
+
+    m_change_depth = 0;
+    m_pending_changes = ChangeSet();
+
     /*
      *  Initialize the system parameters
      */
@@ -225,15 +239,256 @@ Preferences::Preferences( QObject *parent ) : QObject( parent )
 }
 
 
+/*
+ *  Get the path of the snapshot file
+ */
+QString Preferences::snapshotPath() const
+{
+    QString cache = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation );
+
+    return cache + "/SysTray-X/snapshot.bin";
+}
+
+
+/*
+ *  Serialize the icon preferences
+ */
+QByteArray  Preferences::snapshotPayload() const
+{
+    QByteArray payload;
+    QDataStream stream( &payload, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    stream << (qint32)m_default_icon_type << m_default_icon_mime << m_default_icon_data << m_hide_default_icon;
+    stream << (qint32)m_icon_type << m_icon_mime << m_icon_data << m_invert_icon;
+    stream << m_show_number << m_show_new_indicator << (qint32)m_count_type;
+    stream << m_number_color << (qint32)m_number_size << (qint32)m_number_alignment << m_number_margins;
+    stream << (qint32)m_new_indicator_type << m_new_shade_color;
+
+    return payload;
+}
+
+
+/*
+ *  Load the last known icon preferences from the cache
+ */
+bool    Preferences::loadSnapshot()
+{
+    QFile file( snapshotPath() );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QDataStream file_stream( &file );
+    file_stream.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 magic;
+    quint32 version;
+    QByteArray payload;
+    QByteArray hash;
+    file_stream >> magic >> version >> payload >> hash;
+
+    /*
+     *  Reject foreign, old or damaged snapshots
+     */
+    if( file_stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION ||
+            hash != QCryptographicHash::hash( payload, QCryptographicHash::Sha256 ) )
+    {
+        return false;
+    }
+
+    QDataStream stream( payload );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    qint32 default_icon_type;
+    QString default_icon_mime;
+    QByteArray default_icon_data;
+    bool hide_default_icon;
+    qint32 icon_type;
+    QString icon_mime;
+    QByteArray icon_data;
+    bool invert_icon;
+    bool show_number;
+    bool show_new_indicator;
+    qint32 count_type;
+    QString number_color;
+    qint32 number_size;
+    qint32 number_alignment;
+    QMargins number_margins;
+    qint32 new_indicator_type;
+    QString new_shade_color;
+
+    stream >> default_icon_type >> default_icon_mime >> default_icon_data >> hide_default_icon;
+    stream >> icon_type >> icon_mime >> icon_data >> invert_icon;
+    stream >> show_number >> show_new_indicator >> count_type;
+    stream >> number_color >> number_size >> number_alignment >> number_margins;
+    stream >> new_indicator_type >> new_shade_color;
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+
+    beginChanges();
+
+    setDefaultIconType( static_cast< DefaultIconType >( default_icon_type ) );
+    setDefaultIconMime( default_icon_mime );
+    setDefaultIconData( default_icon_data );
+    setHideDefaultIcon( hide_default_icon );
+    setIconType( static_cast< IconType >( icon_type ) );
+    setIconMime( icon_mime );
+    setIconData( icon_data );
+    setInvertIcon( invert_icon );
+    setShowNumber( show_number );
+    setShowNewIndicator( show_new_indicator );
+    setCountType( static_cast< CountType >( count_type ) );
+    setNumberColor( number_color );
+    setNumberSize( number_size );
+    setNumberAlignment( number_alignment );
+    setNumberMargins( number_margins );
+    setNewIndicatorType( static_cast< NewIndicatorType >( new_indicator_type ) );
+    setNewShadeColor( new_shade_color );
+
+    commitChanges();
+
+    m_snapshot_hash = hash;
+
+    return true;
+}
+
+
+/*
+ *  Store the icon preferences in the cache, if changed
+ */
+void    Preferences::saveSnapshot()
+{
+    QByteArray payload = snapshotPayload();
+    QByteArray hash = QCryptographicHash::hash( payload, QCryptographicHash::Sha256 );
+
+    if( hash == m_snapshot_hash )
+    {
+        return;
+    }
+
+    QString path = snapshotPath();
+    QDir().mkpath( QFileInfo( path ).absolutePath() );
+
+    /*
+     *  Write a new file and replace the old one, never leave a partial snapshot
+     */
+    QSaveFile file( path );
+    if( !file.open( QIODevice::WriteOnly ) )
+    {
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << (quint32)SNAPSHOT_MAGIC << (quint32)SNAPSHOT_VERSION << payload << hash;
+
+    if( file.commit() )
+    {
+        m_snapshot_hash = hash;
+    }
+}
+
+
+/*
+ *  Get the SHA-256 of the default icon data
+ */
+QString Preferences::getDefaultIconHash() const
+{
+    return QString::fromLatin1( QCryptographicHash::hash( m_default_icon_data, QCryptographicHash::Sha256 ).toHex() );
+}
+
+
+/*
+ *  Get the SHA-256 of the icon data
+ */
+QString Preferences::getIconHash() const
+{
+    return QString::fromLatin1( QCryptographicHash::hash( m_icon_data, QCryptographicHash::Sha256 ).toHex() );
+}
+
+
+/*
+ *  Get a copy of the window control preferences
+ */
+Preferences::WindowSettings Preferences::getWindowSettings() const
+{
+    WindowSettings settings;
+    settings.minimize_type = m_minimize_type;
+    settings.minimize_icon_type = m_minimize_icon_type;
+    settings.close_type = m_close_type;
+    settings.window_positions_correction = m_window_positions_correction;
+    settings.window_positions_correction_type = m_window_positions_correction_type;
+
+    return settings;
+}
+
+
+/*
+ *  Start collecting the preference changes
+ */
+void    Preferences::beginChanges()
+{
+    m_change_depth++;
+}
+
+
+/*
+ *  Emit the collected preference changes
+ */
+void    Preferences::commitChanges()
+{
+    if( m_change_depth == 0 )
+    {
+        return;
+    }
+
+    if( --m_change_depth == 0 && m_pending_changes != ChangeSet() )
+    {
+        ChangeSet changes = m_pending_changes;
+        m_pending_changes = ChangeSet();
+
+        /*
+         *  Tell the world the new preferences
+         */
+        TraceSpan span( "Preferences apply", "preferences" );
+
+        emit signalChanged( changes );
+    }
+}
+
+
+/*
+ *  Emit or collect a preference change
+ */
+void    Preferences::changed( ChangeSet changes )
+{
+    if( m_change_depth > 0 )
+    {
+        m_pending_changes |= changes;
+    }
+    else
+    {
+        TraceSpan span( "Preferences apply", "preferences" );
+
+        emit signalChanged( changes );
+    }
+}
+
+
 /*
  *  Display some debug info
  */
 void    Preferences::displayDebug()
 {
-    emit signalConsole( QString( "Platform: %1" ).arg( m_platform ) );
-    emit signalConsole( QString( "Session current desktop: %1" ).arg( m_xdg_current_desktop ) );
-    emit signalConsole( QString( "Session desktop: %1" ).arg( m_xdg_session_desktop ) );
-    emit signalConsole( QString( "Session type: %1" ).arg( m_xdg_session_type ) );
+    LOG_INFO( QString( "Platform: %1" ).arg( m_platform ) );
+    LOG_INFO( QString( "Session current desktop: %1" ).arg( m_xdg_current_desktop ) );
+    LOG_INFO( QString( "Session desktop: %1" ).arg( m_xdg_session_desktop ) );
+    LOG_INFO( QString( "Session type: %1" ).arg( m_xdg_session_type ) );
 }
 
 
@@ -366,7 +621,7 @@ void    Preferences::setMinimizeType( MinimizeType minimize_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalMinimizeTypeChange();
+        changed( CHANGE_MINIMIZE_TYPE );
     }
 }
 
@@ -392,7 +647,7 @@ void    Preferences::setCloseType( CloseType close_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalCloseTypeChange();
+        changed( CHANGE_CLOSE_TYPE );
     }
 }
 
@@ -418,7 +673,7 @@ void    Preferences::setMinimizeIconType( MinimizeIconType minimize_icon_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalMinimizeIconTypeChange();
+        changed( CHANGE_MINIMIZE_ICON_TYPE );
     }
 }
 
@@ -444,7 +699,7 @@ void    Preferences::setStartupType( Preferences::StartupType startup_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalStartupTypeChange();
+        changed( CHANGE_STARTUP_TYPE );
     }
 }
 
@@ -470,7 +725,7 @@ void    Preferences::setWindowPositionsCorrection( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalWindowPositionsCorrectionChange();
+        changed( CHANGE_WINDOW_POSITIONS_CORRECTION );
     }
 }
 
@@ -496,7 +751,7 @@ void    Preferences::setWindowPositionsCorrectionType( WindowPositionsCorrection
         /*
          *  Tell the world the new preference
          */
-        emit signalWindowPositionsCorrectionTypeChange();
+        changed( CHANGE_WINDOW_POSITIONS_CORRECTION_TYPE );
     }
 }
 
@@ -522,7 +777,7 @@ void    Preferences::setRestoreWindowPositions( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalRestoreWindowPositionsChange();
+        changed( CHANGE_RESTORE_WINDOW_POSITIONS );
     }
 }
 
@@ -548,7 +803,7 @@ void    Preferences::setDefaultIconType( DefaultIconType icon_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalDefaultIconTypeChange();
+        changed( CHANGE_DEFAULT_ICON_TYPE );
     }
 }
 
@@ -593,7 +848,7 @@ void    Preferences::setDefaultIconData( const QByteArray& icon_data )
         /*
          *  Tell the world the new preference
          */
-        emit signalDefaultIconDataChange();
+        changed( CHANGE_DEFAULT_ICON_DATA );
     }
 }
 
@@ -619,7 +874,7 @@ void    Preferences::setHideDefaultIcon( bool hide )
         /*
          *  Tell the world the new preference
          */
-        emit signalHideDefaultIconChange();
+        changed( CHANGE_HIDE_DEFAULT_ICON );
     }
 }
 
@@ -645,7 +900,7 @@ void    Preferences::setIconType( IconType icon_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalIconTypeChange();
+        changed( CHANGE_ICON_TYPE );
     }
 }
 
@@ -690,7 +945,7 @@ void    Preferences::setIconData( const QByteArray& icon_data )
         /*
          *  Tell the world the new preference
          */
-        emit signalIconDataChange();
+        changed( CHANGE_ICON_DATA );
     }
 }
 
@@ -716,7 +971,7 @@ void    Preferences::setInvertIcon( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalInvertIconChange();
+        changed( CHANGE_INVERT_ICON );
     }
 }
 
@@ -742,7 +997,7 @@ void    Preferences::setShowNumber( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalShowNumberChange();
+        changed( CHANGE_SHOW_NUMBER );
     }
 }
 
@@ -768,7 +1023,7 @@ void    Preferences::setShowNewIndicator( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalShowNewIndicatorChange();
+        changed( CHANGE_SHOW_NEW_INDICATOR );
     }
 }
 
@@ -794,7 +1049,7 @@ void    Preferences::setCountType( CountType count_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalCountTypeChange();
+        changed( CHANGE_COUNT_TYPE );
     }
 }
 
@@ -820,7 +1075,7 @@ void    Preferences::setStartupDelay( int delay )
         /*
          *  Tell the world the new preference
          */
-        emit signalStartupDelayChange();
+        changed( CHANGE_STARTUP_DELAY );
     }
 }
 
@@ -846,7 +1101,7 @@ void    Preferences::setNumberColor( QString color )
         /*
          *  Tell the world the new preference
          */
-        emit signalNumberColorChange();
+        changed( CHANGE_NUMBER_COLOR );
     }
 }
 
@@ -872,7 +1127,7 @@ void    Preferences::setNumberSize( int size )
         /*
          *  Tell the world the new preference
          */
-        emit signalNumberSizeChange();
+        changed( CHANGE_NUMBER_SIZE );
     }
 }
 
@@ -898,7 +1153,7 @@ void    Preferences::setNumberAlignment( int alignment )
         /*
          *  Tell the world the new preference
          */
-        emit signalNumberAlignmentChange();
+        changed( CHANGE_NUMBER_ALIGNMENT );
     }
 }
 
@@ -924,7 +1179,7 @@ void    Preferences::setNumberMargins( QMargins margins )
         /*
          *  Tell the world the new preference
          */
-        emit signalNumberMarginsChange();
+        changed( CHANGE_NUMBER_MARGINS );
     }
 }
 
@@ -950,7 +1205,7 @@ void    Preferences::setNewIndicatorType( NewIndicatorType new_indicator_type )
         /*
          *  Tell the world the new preference
          */
-        emit signalNewIndicatorTypeChange();
+        changed( CHANGE_NEW_INDICATOR_TYPE );
     }
 }
 
@@ -976,7 +1231,7 @@ void    Preferences::setNewShadeColor( QString color )
         /*
          *  Tell the world the new preference
          */
-        emit signalNewShadeColorChange();
+        changed( CHANGE_NEW_SHADE_COLOR );
     }
 }
 
@@ -1003,7 +1258,7 @@ void    Preferences::setStartApp( QString app )
         /*
          *  Tell the world the new preference
          */
-        emit signalStartAppChange();
+        changed( CHANGE_START_APP );
     }
 }
 
@@ -1030,7 +1285,7 @@ void    Preferences::setStartAppArgs( QString args )
         /*
          *  Tell the world the new preference
          */
-        emit signalStartAppArgsChange();
+        changed( CHANGE_START_APP_ARGS );
     }
 }
 
@@ -1057,7 +1312,7 @@ void    Preferences::setCloseApp( QString app )
         /*
          *  Tell the world the new preference
          */
-        emit signalCloseAppChange();
+        changed( CHANGE_CLOSE_APP );
     }
 }
 
@@ -1084,7 +1339,7 @@ void    Preferences::setCloseAppArgs( QString args )
         /*
          *  Tell the world the new preference
          */
-        emit signalCloseAppArgsChange();
+        changed( CHANGE_CLOSE_APP_ARGS );
     }
 }
 
@@ -1110,7 +1365,7 @@ void    Preferences::setApiCountMethod( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalApiCountMethodChange();
+        changed( CHANGE_API_COUNT_METHOD );
     }
 }
 
@@ -1136,7 +1391,7 @@ void    Preferences::setShowHideShortcut( QKeySequence key_seq )
         /*
          *  Tell the world the new preference
          */
-        emit signalShowHideShortcutChange();
+        changed( CHANGE_SHOW_HIDE_SHORTCUT );
     }
 }
 
@@ -1214,6 +1469,6 @@ void    Preferences::setDebug( bool state )
         /*
          *  Tell the world the new preference
          */
-        emit signalDebugChange();
+        changed( CHANGE_DEBUG );
     }
 }
@@ -15,6 +15,12 @@
 #include <QMargins>
 #include <QKeySequence>
 
+/*
+ *  Snapshot file format
+ */
+#define SNAPSHOT_MAGIC      0x53545853
+#define SNAPSHOT_VERSION    1
+
 
 /**
  * @brief The Preferences class. Class to hold the preferences.
@@ -129,6 +135,57 @@ class Preferences : public QObject
 
         static const QStringList  WindowStateString;
 
+        /**
+         * @brief The WindowSettings class. Copy of the preferences used by the window control thread.
+         */
+        class WindowSettings
+        {
+            public:
+
+                MinimizeType    minimize_type;
+                MinimizeIconType    minimize_icon_type;
+                CloseType   close_type;
+                bool    window_positions_correction;
+                WindowPositionsCorrectionType   window_positions_correction_type;
+        };
+
+        /*
+         *  Change set flags
+         */
+        enum ChangeFlag {
+            CHANGE_MINIMIZE_TYPE = 1 << 0,
+            CHANGE_CLOSE_TYPE = 1 << 1,
+            CHANGE_MINIMIZE_ICON_TYPE = 1 << 2,
+            CHANGE_STARTUP_TYPE = 1 << 3,
+            CHANGE_WINDOW_POSITIONS_CORRECTION = 1 << 4,
+            CHANGE_WINDOW_POSITIONS_CORRECTION_TYPE = 1 << 5,
+            CHANGE_RESTORE_WINDOW_POSITIONS = 1 << 6,
+            CHANGE_DEFAULT_ICON_TYPE = 1 << 7,
+            CHANGE_DEFAULT_ICON_DATA = 1 << 8,
+            CHANGE_HIDE_DEFAULT_ICON = 1 << 9,
+            CHANGE_ICON_TYPE = 1 << 10,
+            CHANGE_ICON_DATA = 1 << 11,
+            CHANGE_INVERT_ICON = 1 << 12,
+            CHANGE_SHOW_NUMBER = 1 << 13,
+            CHANGE_SHOW_NEW_INDICATOR = 1 << 14,
+            CHANGE_COUNT_TYPE = 1 << 15,
+            CHANGE_STARTUP_DELAY = 1 << 16,
+            CHANGE_NUMBER_COLOR = 1 << 17,
+            CHANGE_NUMBER_SIZE = 1 << 18,
+            CHANGE_NUMBER_ALIGNMENT = 1 << 19,
+            CHANGE_NUMBER_MARGINS = 1 << 20,
+            CHANGE_NEW_INDICATOR_TYPE = 1 << 21,
+            CHANGE_NEW_SHADE_COLOR = 1 << 22,
+            CHANGE_START_APP = 1 << 23,
+            CHANGE_START_APP_ARGS = 1 << 24,
+            CHANGE_CLOSE_APP = 1 << 25,
+            CHANGE_CLOSE_APP_ARGS = 1 << 26,
+            CHANGE_API_COUNT_METHOD = 1 << 27,
+            CHANGE_SHOW_HIDE_SHORTCUT = 1 << 28,
+            CHANGE_DEBUG = 1 << 29
+        };
+        Q_DECLARE_FLAGS( ChangeSet, ChangeFlag )
+
     public:
 
         /**
@@ -141,6 +198,49 @@ class Preferences : public QObject
          */
         void    displayDebug();
 
+        /**
+         * @brief beginChanges. Start collecting preference changes.
+         */
+        void    beginChanges();
+
+        /**
+         * @brief commitChanges. Emit the collected preference changes as one change set.
+         */
+        void    commitChanges();
+
+        /**
+         * @brief loadSnapshot. Load the last known icon preferences from the cache.
+         *
+         *  @return     True if a valid snapshot was loaded.
+         */
+        bool    loadSnapshot();
+
+        /**
+         * @brief saveSnapshot. Store the icon preferences in the cache, if changed.
+         */
+        void    saveSnapshot();
+
+        /**
+         * @brief getDefaultIconHash. Get the SHA-256 of the default icon data.
+         *
+         *  @return     The hash as hex string.
+         */
+        QString getDefaultIconHash() const;
+
+        /**
+         * @brief getIconHash. Get the SHA-256 of the icon data.
+         *
+         *  @return     The hash as hex string.
+         */
+        QString getIconHash() const;
+
+        /**
+         * @brief getWindowSettings. Get a copy of the window control preferences.
+         *
+         *  @return     The settings.
+         */
+        WindowSettings  getWindowSettings() const;
+
         /**
          * @brief setPlatformOs. Set the platform OS.
          *
@@ -700,163 +800,51 @@ class Preferences : public QObject
     signals:
 
         /**
-         * @brief signalConsole. Send a console message.
+         * @brief signalChanged. Signal a set of preference changes.
          *
-         *  @param message      The message.
+         *  @param changes      The changed preferences.
          */
-        void    signalConsole( QString message );
+        void    signalChanged( Preferences::ChangeSet changes );
 
-        /**
-         * @brief signalMinimizeTypeChange. Signal a minimize type change.
-         */
-        void signalMinimizeTypeChange();
-
-        /**
-         * @brief signalCloseTypeChange. Signal a close type change.
-         */
-        void signalCloseTypeChange();
-
-        /**
-         * @brief signalMinimizeIconTypeChange. Signal a minimize icon type change.
-         */
-        void signalMinimizeIconTypeChange();
-
-        /**
-         * @brief signalStartupTypeChange. Signal a startup type change.
-         */
-        void signalStartupTypeChange();
-
-        /**
-         * @brief signalWindowPositionsCorrectionChange. Signal a window positions correction change.
-         */
-        void signalWindowPositionsCorrectionChange();
-
-        /**
-         * @brief signalWindowPositionsCorrectionTypeChange. Signal a window positions correction type change.
-         */
-        void signalWindowPositionsCorrectionTypeChange();
-
-        /**
-         * @brief signalRestoreWindowPositionsChange. Signal a restore window positions state change.
-         */
-        void signalRestoreWindowPositionsChange();
-
-        /**
-         * @brief signalDefaultIconTypeChange. Signal a default icon type change.
-         */
-        void signalDefaultIconTypeChange();
-
-        /**
-         * @brief signalDefaultIconDataChange. Signal a default icon data change.
-         */
-        void signalDefaultIconDataChange();
-
-        /**
-         * @brief signalHideDefaultIconChange. Signal a hide default icon change.
-         */
-        void signalHideDefaultIconChange();
-
-        /**
-         * @brief signalIconTypeChange. Signal a icon type change.
-         */
-        void signalIconTypeChange();
-
-        /**
-         * @brief signalIconDataChange. Signal a icon data change.
-         */
-        void signalIconDataChange();
-
-        /**
-         * @brief signalInvertIconChange. Signal an invert icon state change.
-         */
-        void signalInvertIconChange();
-
-        /**
-         * @brief signalShowNumberChange. Signal a show number state change.
-         */
-        void signalShowNumberChange();
-
-        /**
-         * @brief signalShowNewIndicatorChange. Signal a show new indicator state change.
-         */
-        void signalShowNewIndicatorChange();
-
-        /**
-         * @brief signalCountTypeChange. Signal a count type change.
-         */
-        void signalCountTypeChange();
-
-        /**
-         * @brief signalStartupDelayChange. Signal a startup delay change.
-         */
-        void signalStartupDelayChange();
-
-        /**
-         * @brief signalNumberColorChange. Signal a number color change.
-         */
-        void signalNumberColorChange();
-
-        /**
-         * @brief signalNumberSizeChange. Signal a number size change.
-         */
-        void signalNumberSizeChange();
-
-        /**
-         * @brief signalNumberAlignmmentChange. Signal a number alignment change.
-         */
-        void signalNumberAlignmentChange();
-
-        /**
-         * @brief signalNumberMarginsChange. Signal a number margins change.
-         */
-        void signalNumberMarginsChange();
-
-        /**
-         * @brief signalNewIndicatorTypeChange. Signal a new indicator type change.
-         */
-        void signalNewIndicatorTypeChange();
-
-        /**
-         * @brief signalNewShadeColorChange. Signal a new shade color change.
-         */
-        void signalNewShadeColorChange();
+    private:
 
         /**
-         * @brief signalDebugChange. Signal a debug state change.
+         * @brief snapshotPath. Get the path of the snapshot file.
+         *
+         *  @return     The path.
          */
-        void signalDebugChange();
+        QString snapshotPath() const;
 
         /**
-         * @brief signalStartAppChange. Signal a start application change.
+         * @brief snapshotPayload. Serialize the icon preferences.
+         *
+         *  @return     The payload.
          */
-        void signalStartAppChange();
+        QByteArray  snapshotPayload() const;
 
         /**
-         * @brief signalStartAppArgsChange. Signal a start application arguments change.
+         * @brief changed. Emit or collect a preference change.
+         *
+         *  @param changes      The changed preferences.
          */
-        void signalStartAppArgsChange();
+        void    changed( ChangeSet changes );
 
-        /**
-         * @brief signalCloseAppChange. Signal a close application change.
-         */
-        void signalCloseAppChange();
+    private:
 
         /**
-         * @brief signalCloseAppArgsChange. Signal a close application arguments change.
+         * @brief m_snapshot_hash. SHA-256 of the last loaded or saved snapshot payload.
          */
-        void signalCloseAppArgsChange();
+        QByteArray  m_snapshot_hash;
 
         /**
-         * @brief signalApiCountMethodChange. Signal the api count method change.
+         * @brief m_change_depth. Nesting depth of the change transactions.
          */
-        void signalApiCountMethodChange();
+        int m_change_depth;
 
         /**
-         * @brief signalShowHideShortcutChange. Signal the show / hide shortcut key sequence change.
+         * @brief m_pending_changes. Changes collected during a transaction.
          */
-        void signalShowHideShortcutChange();
-
-    private:
+        ChangeSet   m_pending_changes;
 
         /**
          * @brief m_platform. Qt platform indication.
@@ -1093,4 +1081,10 @@ class Preferences : public QObject
         bool m_debug;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS( Preferences::ChangeSet )
+
+Q_DECLARE_METATYPE( Preferences::WindowState )
+Q_DECLARE_METATYPE( Preferences::ChangeSet )
+Q_DECLARE_METATYPE( Preferences::WindowSettings )
+
 #endif // PREFERENCES_H
@@ -162,52 +162,9 @@ PreferencesDialog::PreferencesDialog( SysTrayXLink *link, Preferences *pref, QWi
     connect( m_ui->clearShowHideShortcutPushButton, &QPushButton::clicked, this, &PreferencesDialog::slotClearShowHideShortcut );
 
     /*
-     *  Set number color
+     *  Only exists while shown, the values are loaded by slotShowDialog
      */
-    setNumberColor( m_pref->getNumberColor() );
-
-    /*
-     *  Set number size
-     */
-    setNumberSize( m_pref->getNumberSize() );
-
-    /*
-     *  Set startup delay
-     */
-    setStartupDelay( m_pref->getStartupDelay() );
-
-    /*
-     *  Set API count method
-     */
-    setApiCountMethod( m_pref->getApiCountMethod() );
-
-    /*
-     *  Set number alignment
-     */
-    setNumberAlignment( m_pref->getNumberAlignment() );
-
-    /*
-     *  Set number margins
-     */
-    setNumberMargins( m_pref->getNumberMargins() );
-
-    /*
-     *  Set new shade color
-     */
-    setNewShadeColor( m_pref->getNewShadeColor() );
-
-    /*
-     *  Set the start and close application parameters
-     */
-    setStartApp( m_pref->getStartApp() );
-    setStartAppArgs( m_pref->getStartAppArgs() );
-    setCloseApp( m_pref->getCloseApp() );
-    setCloseAppArgs( m_pref->getCloseAppArgs() );
-
-    /*
-     *  Set the show / hide shortcut
-     */
-    setShowHideShortcut( m_pref->getShowHideShortcut() );
+    setAttribute( Qt::WA_DeleteOnClose );
 
     /*
      *  Dialog on top
@@ -223,6 +180,15 @@ PreferencesDialog::PreferencesDialog( SysTrayXLink *link, Preferences *pref, QWi
 }
 
 
+/*
+ *  Destructor
+ */
+PreferencesDialog::~PreferencesDialog()
+{
+    delete m_ui;
+}
+
+
 /*
  *  Hide the shortcuts tab
  */
@@ -618,11 +584,60 @@ void    PreferencesDialog::setShowHideShortcut( QKeySequence key_seq )
 }
 
 
+/*
+ *  Load all parameters from the preferences
+ */
+void    PreferencesDialog::loadPreferences()
+{
+    setDefaultIconType( m_pref->getDefaultIconType() );
+    slotDefaultIconDataChange();
+    setHideDefaultIcon( m_pref->getHideDefaultIcon() );
+
+    setIconType( m_pref->getIconType() );
+    slotIconDataChange();
+
+    setMinimizeType( m_pref->getMinimizeType() );
+    setMinimizeIconType( m_pref->getMinimizeIconType() );
+    setCloseType( m_pref->getCloseType() );
+    setStartupType( m_pref->getStartupType() );
+    setWindowPositionsCorrection( m_pref->getWindowPositionsCorrection() );
+    setWindowPositionsCorrectionType( m_pref->getWindowPositionsCorrectionType() );
+    setRestoreWindowPositions( m_pref->getRestoreWindowPositions() );
+    setInvertIcon( m_pref->getInvertIcon() );
+
+    setShowNumber( m_pref->getShowNumber() );
+    setShowNewIndicator( m_pref->getShowNewIndicator() );
+    setStartupDelay( m_pref->getStartupDelay() );
+    setApiCountMethod( m_pref->getApiCountMethod() );
+    setCountType( m_pref->getCountType() );
+    setNumberColor( m_pref->getNumberColor() );
+    setNumberSize( m_pref->getNumberSize());
+    setNumberAlignment( m_pref->getNumberAlignment() );
+    setNumberMargins( m_pref->getNumberMargins() );
+    setNewIndicatorType( m_pref->getNewIndicatorType() );
+    setNewShadeColor( m_pref->getNewShadeColor() );
+
+    setStartApp( m_pref->getStartApp() );
+    setStartAppArgs( m_pref->getStartAppArgs() );
+    setCloseApp( m_pref->getCloseApp() );
+    setCloseAppArgs( m_pref->getCloseAppArgs() );
+
+    setShowHideShortcut( m_pref->getShowHideShortcut() );
+
+    setDebug( m_pref->getDebug());
+}
+
+
 /*
  *  Handle show dialog signal
  */
 void PreferencesDialog::slotShowDialog()
 {
+    if( !isVisible() )
+    {
+        loadPreferences();
+    }
+
     QString version = m_pref->getBrowserVersion().split(".")[0];
     if( version.toInt() < 115 )
     {
@@ -646,6 +661,8 @@ void    PreferencesDialog::slotAccept()
     /*
      *  Get all the selected values and store them in the preferences
      */
+    m_pref->beginChanges();
+
     m_pref->setDefaultIconType( static_cast< Preferences::DefaultIconType >( m_ui->defaultIconTypeGroup->checkedId() ) );
     m_pref->setDefaultIconMime( m_tmp_default_icon_mime );
     m_pref->setDefaultIconData( m_tmp_default_icon_data );
@@ -691,6 +708,8 @@ void    PreferencesDialog::slotAccept()
 
     m_pref->setDebug( m_ui->debugWindowCheckBox->isChecked() );
 
+    m_pref->commitChanges();
+
     /*
      *  Settings changed by app
      */
@@ -700,7 +719,7 @@ void    PreferencesDialog::slotAccept()
      *  Close it
      */
 //    QDialog::accept();
-    hide();
+    close();
 }
 
 
@@ -713,47 +732,7 @@ void    PreferencesDialog::slotReject()
      *  Close it
      */
 //    QDialog::reject();
-    hide();
-
-    /*
-     *  Reset all parameters
-     */
-    setDefaultIconType( m_pref->getDefaultIconType() );
-    slotDefaultIconDataChange();
-    setHideDefaultIcon( m_pref->getHideDefaultIcon() );
-
-    setIconType( m_pref->getIconType() );
-    slotIconDataChange();
-
-    setMinimizeType( m_pref->getMinimizeType() );
-    setMinimizeIconType( m_pref->getMinimizeIconType() );
-    setCloseType( m_pref->getCloseType() );
-    setStartupType( m_pref->getStartupType() );
-    setWindowPositionsCorrection( m_pref->getWindowPositionsCorrection() );
-    setWindowPositionsCorrectionType( m_pref->getWindowPositionsCorrectionType() );
-    setRestoreWindowPositions( m_pref->getRestoreWindowPositions() );
-    setInvertIcon( m_pref->getInvertIcon() );
-
-    setShowNumber( m_pref->getShowNumber() );
-    setShowNewIndicator( m_pref->getShowNewIndicator() );
-    setStartupDelay( m_pref->getStartupDelay() );
-    setApiCountMethod( m_pref->getApiCountMethod() );
-    setCountType( m_pref->getCountType() );
-    setNumberColor( m_pref->getNumberColor() );
-    setNumberSize( m_pref->getNumberSize());
-    setNumberAlignment( m_pref->getNumberAlignment() );
-    setNumberMargins( m_pref->getNumberMargins() );
-    setNewIndicatorType( m_pref->getNewIndicatorType() );
-    setNewShadeColor( m_pref->getNewShadeColor() );
-
-    setStartApp( m_pref->getStartApp() );
-    setStartAppArgs( m_pref->getStartAppArgs() );
-    setCloseApp( m_pref->getCloseApp() );
-    setCloseAppArgs( m_pref->getCloseAppArgs() );
-
-    setShowHideShortcut( m_pref->getShowHideShortcut() );
-
-    setDebug( m_pref->getDebug());
+    close();
 }
 
 
@@ -864,6 +843,163 @@ void    PreferencesDialog::slotCloseAppSelect()
 }
 
 
+/*
+ *  Handle a preferences change set
+ */
+void    PreferencesDialog::slotPreferencesChanged( Preferences::ChangeSet changes )
+{
+    if( changes.testFlag( Preferences::CHANGE_MINIMIZE_TYPE ) )
+    {
+        slotMinimizeTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_MINIMIZE_ICON_TYPE ) )
+    {
+        slotMinimizeIconTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_CLOSE_TYPE ) )
+    {
+        slotCloseTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_STARTUP_TYPE ) )
+    {
+        slotStartupTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION ) )
+    {
+        slotWindowPositionsCorrectionChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION_TYPE ) )
+    {
+        slotWindowPositionsCorrectionTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_RESTORE_WINDOW_POSITIONS ) )
+    {
+        slotRestoreWindowPositionsChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_DEFAULT_ICON_TYPE ) )
+    {
+        slotDefaultIconTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_DEFAULT_ICON_DATA ) )
+    {
+        slotDefaultIconDataChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_HIDE_DEFAULT_ICON ) )
+    {
+        slotHideDefaultIconChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_ICON_TYPE ) )
+    {
+        slotIconTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_ICON_DATA ) )
+    {
+        slotIconDataChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_INVERT_ICON ) )
+    {
+        slotInvertIconChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_NUMBER ) )
+    {
+        slotShowNumberChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_NEW_INDICATOR ) )
+    {
+        slotShowNewIndicatorChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_COUNT_TYPE ) )
+    {
+        slotCountTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_STARTUP_DELAY ) )
+    {
+        slotStartupDelayChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_API_COUNT_METHOD ) )
+    {
+        slotApiCountMethodChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_COLOR ) )
+    {
+        slotNumberColorChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_SIZE ) )
+    {
+        slotNumberSizeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_ALIGNMENT ) )
+    {
+        slotNumberAlignmentChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_MARGINS ) )
+    {
+        slotNumberMarginsChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NEW_INDICATOR_TYPE ) )
+    {
+        slotNewIndicatorTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NEW_SHADE_COLOR ) )
+    {
+        slotNewShadeColorChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_START_APP ) )
+    {
+        slotStartAppChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_START_APP_ARGS ) )
+    {
+        slotStartAppArgsChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_CLOSE_APP ) )
+    {
+        slotCloseAppChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_CLOSE_APP_ARGS ) )
+    {
+        slotCloseAppArgsChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_HIDE_SHORTCUT ) )
+    {
+        slotShowHideShortcutChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_DEBUG ) )
+    {
+        slotDebugChange();
+    }
+}
+
+
 /*
  *  Handle the debug change signal
  */
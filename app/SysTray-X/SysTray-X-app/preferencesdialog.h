@@ -41,6 +41,11 @@ class PreferencesDialog : public QDialog
          */
         PreferencesDialog( SysTrayXLink *link, Preferences *pref, QWidget *parent = nullptr );
 
+        /**
+         * @brief ~PreferencesDialog. Destructor.
+         */
+        ~PreferencesDialog();
+
         /**
          * @brief changeEvent. Catch the event.
          *
@@ -62,6 +67,11 @@ class PreferencesDialog : public QDialog
          */
         void hideShortcutsTab();
 
+        /**
+         * @brief loadPreferences. Set all widgets from the preferences.
+         */
+        void    loadPreferences();
+
         /**
          * @brief setDebug. Set the debug state.
          *
@@ -293,13 +303,6 @@ class PreferencesDialog : public QDialog
 
     signals:
 
-        /**
-         * @brief signalConsole. Send a console message.
-         *
-         *  @param message      The message.
-         */
-        void    signalConsole( QString message );
-
         /**
          * @brief signalUpdateSysTray. Signal to update the system tray icon.
          */
@@ -317,6 +320,13 @@ class PreferencesDialog : public QDialog
          */
         void    slotShowDialog();
 
+        /**
+         * @brief slotPreferencesChanged. Slot for handling a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         */
+        void    slotPreferencesChanged( Preferences::ChangeSet changes );
+
         /**
          * @brief slotDebugChange. Slot for handling debug change signals.
          */
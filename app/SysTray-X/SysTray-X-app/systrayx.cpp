@@ -10,6 +10,7 @@
 #include "systrayxstatusnotifier.h"
 #include "windowctrl.h"
 #include "shortcut.h"
+#include "logger.h"
 
 /*
  *	Qt includes
@@ -19,6 +20,12 @@
 #include <QMenu>
 #include <QIcon>
 #include <QTimer>
+#include <QThread>
+
+/*
+ *  System includes
+ */
+#include <stdio.h>
 
 
 /*
@@ -46,16 +53,51 @@ SysTrayX::SysTrayX( QObject *parent ) : QObject( parent )
 
     m_show_hide_shortcut = nullptr;
 
+    m_win_ctrl_thread = nullptr;
+
+    m_debug = nullptr;
+
+    /*
+     *  Setup the startup trace
+     */
+    m_startup_trace = !qgetenv( STARTUP_TRACE_ENV ).isEmpty();
+    m_startup_clock.start();
+    m_startup_mark = 0;
+    m_startup_icon = false;
+    m_startup_handshake = false;
+
+    /*
+     *  Setup the log file, when requested
+     */
+    m_log_sink = nullptr;
+
+    QString log_file = QString::fromLocal8Bit( qgetenv( LOG_FILE_ENV ) );
+    if( !log_file.isEmpty() )
+    {
+        m_log_sink = new LoggerFileSink( log_file, this );
+    }
+
     /*
      *  Setup preferences storage
      */
     m_preferences = new Preferences();
 
+    setLogLevel();
+
+    /*
+     *  Get the last known icon preferences
+     */
+    bool snapshot = m_preferences->loadSnapshot();
+
+    traceStartup( snapshot ? "preferences (snapshot)" : "preferences" );
+
     /*
      *  Setup window control
      */
     m_win_ctrl = new WindowCtrl( m_preferences );
 
+    traceStartup( "window control" );
+
 #ifdef QT_NO_DEBUG
 
     if( !m_win_ctrl->thunderbirdStart() )
@@ -73,34 +115,24 @@ SysTrayX::SysTrayX( QObject *parent ) : QObject( parent )
      */
     m_link = new SysTrayXLink( m_preferences );
 
-    /*
-     *  Setup preferences dialog
-     */
-    m_pref_dialog = new PreferencesDialog( m_link, m_preferences );
+    traceStartup( "link" );
 
     /*
-     *  Setup debug window
+     *  The preferences dialog is created when it is opened
      */
-    m_debug = new DebugWidget( m_preferences );
-    if( m_preferences->getDebug() ) {
-        m_debug->show();
-    }
+    m_pref_dialog = nullptr;
 
     /*
-     *  Connect debug link signals
+     *  Setup debug window, only when debugging
      */
-    connect( m_link, &SysTrayXLink::signalMailCount, m_debug, &DebugWidget::slotMailCount );
+    if( m_preferences->getDebug() )
+    {
+        createDebugWidget();
+    }
 
-    connect( this, &SysTrayX::signalConsole, m_debug, &DebugWidget::slotConsole );
-    connect( m_preferences, &Preferences::signalConsole, m_debug, &DebugWidget::slotConsole );
-    connect( m_pref_dialog, &PreferencesDialog::signalConsole, m_debug, &DebugWidget::slotConsole );
-    connect( m_link, &SysTrayXLink::signalConsole, m_debug, &DebugWidget::slotConsole );
-    connect( m_win_ctrl, &WindowCtrl::signalConsole, m_debug, &DebugWidget::slotConsole );
+    connect( m_preferences, &Preferences::signalChanged, this, &SysTrayX::slotPreferencesChanged );
 
-    connect( m_debug, &DebugWidget::signalTest1ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest1 );
-    connect( m_debug, &DebugWidget::signalTest2ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest2 );
-    connect( m_debug, &DebugWidget::signalTest3ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest3 );
-    connect( m_debug, &DebugWidget::signalTest4ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest4 );
+    traceStartup( "debug window" );
 
 #ifdef Q_OS_UNIX
 
@@ -109,57 +141,9 @@ SysTrayX::SysTrayX( QObject *parent ) : QObject( parent )
 #endif
 
     /*
-     *  Connect preferences signals
+     *  Connect preferences signals, the window control gets a copy of its preferences
      */
-    connect( m_preferences, &Preferences::signalMinimizeTypeChange, m_win_ctrl, &WindowCtrl::slotMinimizeTypeChange );
-    connect( m_preferences, &Preferences::signalMinimizeIconTypeChange, m_win_ctrl, &WindowCtrl::slotMinimizeIconTypeChange );
-    connect( m_preferences, &Preferences::signalCloseTypeChange, m_win_ctrl, &WindowCtrl::slotCloseTypeChange );
-
-    connect( m_preferences, &Preferences::signalDefaultIconTypeChange, m_pref_dialog, &PreferencesDialog::slotDefaultIconTypeChange );
-    connect( m_preferences, &Preferences::signalDefaultIconDataChange, m_pref_dialog, &PreferencesDialog::slotDefaultIconDataChange );
-    connect( m_preferences, &Preferences::signalHideDefaultIconChange, m_pref_dialog, &PreferencesDialog::slotHideDefaultIconChange );
-    connect( m_preferences, &Preferences::signalIconTypeChange, m_pref_dialog, &PreferencesDialog::slotIconTypeChange );
-    connect( m_preferences, &Preferences::signalIconDataChange, m_pref_dialog, &PreferencesDialog::slotIconDataChange );
-    connect( m_preferences, &Preferences::signalMinimizeTypeChange, m_pref_dialog, &PreferencesDialog::slotMinimizeTypeChange );
-    connect( m_preferences, &Preferences::signalMinimizeIconTypeChange, m_pref_dialog, &PreferencesDialog::slotMinimizeIconTypeChange );
-    connect( m_preferences, &Preferences::signalWindowPositionsCorrectionChange, m_pref_dialog, &PreferencesDialog::slotWindowPositionsCorrectionChange );
-    connect( m_preferences, &Preferences::signalWindowPositionsCorrectionTypeChange, m_pref_dialog, &PreferencesDialog::slotWindowPositionsCorrectionTypeChange );
-    connect( m_preferences, &Preferences::signalStartupTypeChange, m_pref_dialog, &PreferencesDialog::slotStartupTypeChange );
-    connect( m_preferences, &Preferences::signalRestoreWindowPositionsChange, m_pref_dialog, &PreferencesDialog::slotRestoreWindowPositionsChange );
-    connect( m_preferences, &Preferences::signalCloseTypeChange, m_pref_dialog, &PreferencesDialog::slotCloseTypeChange );
-    connect( m_preferences, &Preferences::signalInvertIconChange, m_pref_dialog, &PreferencesDialog::slotInvertIconChange );
-    connect( m_preferences, &Preferences::signalShowNumberChange, m_pref_dialog, &PreferencesDialog::slotShowNumberChange );
-    connect( m_preferences, &Preferences::signalShowNewIndicatorChange, m_pref_dialog, &PreferencesDialog::slotShowNewIndicatorChange );
-    connect( m_preferences, &Preferences::signalStartupDelayChange, m_pref_dialog, &PreferencesDialog::slotStartupDelayChange );
-    connect( m_preferences, &Preferences::signalApiCountMethodChange, m_pref_dialog, &PreferencesDialog::slotApiCountMethodChange );
-    connect( m_preferences, &Preferences::signalCountTypeChange, m_pref_dialog, &PreferencesDialog::slotCountTypeChange );
-    connect( m_preferences, &Preferences::signalNumberColorChange, m_pref_dialog, &PreferencesDialog::slotNumberColorChange );
-    connect( m_preferences, &Preferences::signalNumberSizeChange, m_pref_dialog, &PreferencesDialog::slotNumberSizeChange );
-    connect( m_preferences, &Preferences::signalNumberAlignmentChange, m_pref_dialog, &PreferencesDialog::slotNumberAlignmentChange );
-    connect( m_preferences, &Preferences::signalNumberMarginsChange, m_pref_dialog, &PreferencesDialog::slotNumberMarginsChange );
-    connect( m_preferences, &Preferences::signalNewIndicatorTypeChange, m_pref_dialog, &PreferencesDialog::slotNewIndicatorTypeChange );
-    connect( m_preferences, &Preferences::signalNewShadeColorChange, m_pref_dialog, &PreferencesDialog::slotNewShadeColorChange );
-    connect( m_preferences, &Preferences::signalStartAppChange, m_pref_dialog, &PreferencesDialog::slotStartAppChange );
-    connect( m_preferences, &Preferences::signalStartAppArgsChange, m_pref_dialog, &PreferencesDialog::slotStartAppArgsChange );
-    connect( m_preferences, &Preferences::signalCloseAppChange, m_pref_dialog, &PreferencesDialog::slotCloseAppChange );
-    connect( m_preferences, &Preferences::signalCloseAppArgsChange, m_pref_dialog, &PreferencesDialog::slotCloseAppArgsChange );
-    connect( m_preferences, &Preferences::signalShowHideShortcutChange, m_pref_dialog, &PreferencesDialog::slotShowHideShortcutChange );
-    connect( m_preferences, &Preferences::signalDebugChange, m_pref_dialog, &PreferencesDialog::slotDebugChange );
-
-    connect( m_pref_dialog, &PreferencesDialog::signalPreferencesChanged, m_link, &SysTrayXLink::slotPreferencesChanged );
-
-    connect( m_preferences, &Preferences::signalHideDefaultIconChange, this,  &SysTrayX::slotSelectIconObjectPref );
-
-    connect( m_preferences, &Preferences::signalDebugChange, m_debug, &DebugWidget::slotDebugChange );
-
-#if defined( SHORTCUTS )
-
-    if( m_preferences->getShortcutsOption() )
-    {
-        connect( m_preferences, &Preferences::signalShowHideShortcutChange, this, &SysTrayX::slotShowHideShortcutChange );
-    }
-
-#endif
+    connect( this, &SysTrayX::signalWindowCtrlPreferences, m_win_ctrl, &WindowCtrl::slotPreferencesChanged );
 
     /*
      *  Connect link signals
@@ -175,25 +159,75 @@ SysTrayX::SysTrayX( QObject *parent ) : QObject( parent )
     connect( m_link, &SysTrayXLink::signalLocale, this, &SysTrayX::slotLoadLanguage );
     connect( m_link, &SysTrayXLink::signalStartApp, this, &SysTrayX::slotStartApp );
     connect( m_link, &SysTrayXLink::signalCloseApp, this, &SysTrayX::slotCloseApp );
+    connect( m_link, &SysTrayXLink::signalPreferencesReceived, this, &SysTrayX::slotPreferencesReceived );
 
 #ifdef Q_OS_UNIX
 
     connect( m_link, &SysTrayXLink::signalWindowPositions, m_win_ctrl, &WindowCtrl::slotPositions );
 
     connect( m_win_ctrl, &WindowCtrl::signalPositions, m_link, &SysTrayXLink::slotPositions );
+    connect( m_win_ctrl, &WindowCtrl::signalWindowIdentified, m_link, &SysTrayXLink::slotWindowIdentified );
 
 #endif
 
     /*
      *  SysTrayX
      */
+#ifdef Q_OS_UNIX
+
+    /*
+     *  Wait for the windows to be closed before quitting
+     */
+    connect( this, &SysTrayX::signalClose, m_win_ctrl, &WindowCtrl::slotClose, Qt::BlockingQueuedConnection );
+
+#else
+
     connect( this, &SysTrayX::signalClose, m_win_ctrl, &WindowCtrl::slotClose );
 
+#endif
+
+    traceStartup( "connections" );
+
+    /*
+     *  Start the window control
+     */
+#ifdef Q_OS_UNIX
+
+    /*
+     *  X11 calls can block on a slow server, keep them out of the GUI thread
+     */
+    m_win_ctrl_thread = new QThread( this );
+    m_win_ctrl_thread->setObjectName( "Window control" );
+    m_win_ctrl->moveToThread( m_win_ctrl_thread );
+
+    connect( m_win_ctrl_thread, &QThread::finished, m_win_ctrl, &QObject::deleteLater );
+    connect( m_win_ctrl_thread, &QThread::started, m_win_ctrl, &WindowCtrl::slotInitialize );
+
+    m_win_ctrl_thread->start();
+
+#else
+
+    m_win_ctrl->slotInitialize();
+
+#endif
+
+    traceStartup( "window control start" );
+
     /*
      *  Request preferences from add-on
      */
     getPreferences();
 
+    traceStartup( "preferences request" );
+
+    /*
+     *  Show the icon of the last session right away
+     */
+    if( snapshot )
+    {
+        slotSelectIconObjectPref();
+    }
+
     m_preferences->displayDebug();
 
 /*
@@ -221,6 +255,22 @@ SysTrayX::SysTrayX( QObject *parent ) : QObject( parent )
 }
 
 
+/*
+ *  Destructor
+ */
+SysTrayX::~SysTrayX()
+{
+    /*
+     *  Stop the window control thread
+     */
+    if( m_win_ctrl_thread )
+    {
+        m_win_ctrl_thread->quit();
+        m_win_ctrl_thread->wait();
+    }
+}
+
+
 /*
  *  Send a preferences request
  */
@@ -245,7 +295,7 @@ void    SysTrayX::createMenu()
 
     m_pref_action = new QAction(tr("&Preferences"), this);
     m_pref_action->setIcon( QIcon( ":/files/icons/gtk-preferences.png" ) );
-    connect( m_pref_action, &QAction::triggered, m_pref_dialog, &PreferencesDialog::slotShowDialog );
+    connect( m_pref_action, &QAction::triggered, this, &SysTrayX::slotShowPreferencesDialog );
 
     m_about_action = new QAction(tr("&About"), this);
     m_about_action->setIcon( QIcon( ":/files/icons/help-about.png" ) );
@@ -319,19 +369,7 @@ void    SysTrayX::showTrayIcon()
          */
         connect( m_tray_icon, &SysTrayXIcon::signalShowHide, m_win_ctrl, &WindowCtrl::slotShowHide );
 
-        connect( m_preferences, &Preferences::signalDefaultIconTypeChange, m_tray_icon, &SysTrayXIcon::slotDefaultIconTypeChange );
-        connect( m_preferences, &Preferences::signalDefaultIconDataChange, m_tray_icon, &SysTrayXIcon::slotDefaultIconDataChange );
-        connect( m_preferences, &Preferences::signalIconTypeChange, m_tray_icon, &SysTrayXIcon::slotIconTypeChange );
-        connect( m_preferences, &Preferences::signalIconDataChange, m_tray_icon, &SysTrayXIcon::slotIconDataChange );
-        connect( m_preferences, &Preferences::signalInvertIconChange, m_tray_icon, &SysTrayXIcon::slotInvertIconChange );
-        connect( m_preferences, &Preferences::signalShowNumberChange, m_tray_icon, &SysTrayXIcon::slotShowNumberChange );
-        connect( m_preferences, &Preferences::signalShowNewIndicatorChange, m_tray_icon, &SysTrayXIcon::slotShowNewIndicatorChange );
-        connect( m_preferences, &Preferences::signalNumberColorChange, m_tray_icon, &SysTrayXIcon::slotNumberColorChange );
-        connect( m_preferences, &Preferences::signalNumberSizeChange, m_tray_icon, &SysTrayXIcon::slotNumberSizeChange );
-        connect( m_preferences, &Preferences::signalNumberAlignmentChange, m_tray_icon, &SysTrayXIcon::slotNumberAlignmentChange );
-        connect( m_preferences, &Preferences::signalNumberMarginsChange, m_tray_icon, &SysTrayXIcon::slotNumberMarginsChange );
-        connect( m_preferences, &Preferences::signalNewIndicatorTypeChange, m_tray_icon, &SysTrayXIcon::slotNewIndicatorTypeChange );
-        connect( m_preferences, &Preferences::signalNewShadeColorChange, m_tray_icon, &SysTrayXIcon::slotNewShadeColorChange );
+        connect( m_preferences, &Preferences::signalChanged, m_tray_icon, &SysTrayXIcon::slotPreferencesChanged );
 
         connect( m_link, &SysTrayXLink::signalMailCount, m_tray_icon, &SysTrayXIcon::slotMailCount );
 
@@ -342,6 +380,12 @@ void    SysTrayX::showTrayIcon()
          */
         m_tray_icon->show();
 
+        if( !m_startup_icon )
+        {
+            m_startup_icon = true;
+            traceStartup( "first icon" );
+        }
+
         QTimer::singleShot(500, this, &SysTrayX::resendMailCount);
     }
 }
@@ -359,19 +403,7 @@ void    SysTrayX::hideTrayIcon()
          */
         disconnect( m_tray_icon, &SysTrayXIcon::signalShowHide, m_win_ctrl, &WindowCtrl::slotShowHide );
 
-        disconnect( m_preferences, &Preferences::signalDefaultIconTypeChange, m_tray_icon, &SysTrayXIcon::slotDefaultIconTypeChange );
-        disconnect( m_preferences, &Preferences::signalDefaultIconDataChange, m_tray_icon, &SysTrayXIcon::slotDefaultIconDataChange );
-        disconnect( m_preferences, &Preferences::signalIconTypeChange, m_tray_icon, &SysTrayXIcon::slotIconTypeChange );
-        disconnect( m_preferences, &Preferences::signalIconDataChange, m_tray_icon, &SysTrayXIcon::slotIconDataChange );
-        disconnect( m_preferences, &Preferences::signalInvertIconChange, m_tray_icon, &SysTrayXIcon::slotInvertIconChange );
-        disconnect( m_preferences, &Preferences::signalShowNumberChange, m_tray_icon, &SysTrayXIcon::slotShowNumberChange );
-        disconnect( m_preferences, &Preferences::signalShowNewIndicatorChange, m_tray_icon, &SysTrayXIcon::slotShowNewIndicatorChange );
-        disconnect( m_preferences, &Preferences::signalNumberColorChange, m_tray_icon, &SysTrayXIcon::slotNumberColorChange );
-        disconnect( m_preferences, &Preferences::signalNumberSizeChange, m_tray_icon, &SysTrayXIcon::slotNumberSizeChange );
-        disconnect( m_preferences, &Preferences::signalNumberAlignmentChange, m_tray_icon, &SysTrayXIcon::slotNumberAlignmentChange );
-        disconnect( m_preferences, &Preferences::signalNumberMarginsChange, m_tray_icon, &SysTrayXIcon::slotNumberMarginsChange );
-        disconnect( m_preferences, &Preferences::signalNewIndicatorTypeChange, m_tray_icon, &SysTrayXIcon::slotNewIndicatorTypeChange );
-        disconnect( m_preferences, &Preferences::signalNewShadeColorChange, m_tray_icon, &SysTrayXIcon::slotNewShadeColorChange );
+        disconnect( m_preferences, &Preferences::signalChanged, m_tray_icon, &SysTrayXIcon::slotPreferencesChanged );
 
         disconnect( m_link, &SysTrayXLink::signalMailCount, m_tray_icon, &SysTrayXIcon::slotMailCount );
 
@@ -436,20 +468,7 @@ void    SysTrayX::showKdeTrayIcon()
          */
         connect( m_kde_tray_icon, &SysTrayXStatusNotifier::signalShowHide, m_win_ctrl, &WindowCtrl::slotShowHide );
 
-        connect( m_preferences, &Preferences::signalDefaultIconTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotDefaultIconTypeChange );
-        connect( m_preferences, &Preferences::signalDefaultIconDataChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotDefaultIconDataChange );
-        connect( m_preferences, &Preferences::signalHideDefaultIconChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotHideDefaultIconChange );
-        connect( m_preferences, &Preferences::signalIconTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotIconTypeChange );
-        connect( m_preferences, &Preferences::signalIconDataChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotIconDataChange );
-        connect( m_preferences, &Preferences::signalInvertIconChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotInvertIconChange );
-        connect( m_preferences, &Preferences::signalShowNumberChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotShowNumberChange );
-        connect( m_preferences, &Preferences::signalShowNewIndicatorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotShowNewIndicatorChange );
-        connect( m_preferences, &Preferences::signalNumberColorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberColorChange );
-        connect( m_preferences, &Preferences::signalNumberSizeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberSizeChange );
-        connect( m_preferences, &Preferences::signalNumberAlignmentChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberAlignmentChange );
-        connect( m_preferences, &Preferences::signalNumberMarginsChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberMarginsChange );
-        connect( m_preferences, &Preferences::signalNewIndicatorTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNewIndicatorTypeChange );
-        connect( m_preferences, &Preferences::signalNewShadeColorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNewShadeColorChange );
+        connect( m_preferences, &Preferences::signalChanged, m_kde_tray_icon, &SysTrayXStatusNotifier::slotPreferencesChanged );
 
         connect( m_link, &SysTrayXLink::signalMailCount, m_kde_tray_icon, &SysTrayXStatusNotifier::slotMailCount );
 
@@ -458,6 +477,12 @@ void    SysTrayX::showKdeTrayIcon()
         /*
          *  Show
          */
+        if( !m_startup_icon )
+        {
+            m_startup_icon = true;
+            traceStartup( "first icon" );
+        }
+
         QTimer::singleShot(500, this, &SysTrayX::resendMailCount);
     }
 }
@@ -475,20 +500,7 @@ void    SysTrayX::hideKdeTrayIcon()
          */
         disconnect( m_kde_tray_icon, &SysTrayXStatusNotifier::signalShowHide, m_win_ctrl, &WindowCtrl::slotShowHide );
 
-        disconnect( m_preferences, &Preferences::signalDefaultIconTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotDefaultIconTypeChange );
-        disconnect( m_preferences, &Preferences::signalDefaultIconDataChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotDefaultIconDataChange );
-        disconnect( m_preferences, &Preferences::signalHideDefaultIconChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotHideDefaultIconChange );
-        disconnect( m_preferences, &Preferences::signalIconTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotIconTypeChange );
-        disconnect( m_preferences, &Preferences::signalIconDataChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotIconDataChange );
-        disconnect( m_preferences, &Preferences::signalInvertIconChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotInvertIconChange );
-        disconnect( m_preferences, &Preferences::signalShowNumberChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotShowNumberChange );
-        disconnect( m_preferences, &Preferences::signalShowNewIndicatorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotShowNewIndicatorChange );
-        disconnect( m_preferences, &Preferences::signalNumberColorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberColorChange );
-        disconnect( m_preferences, &Preferences::signalNumberSizeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberSizeChange );
-        disconnect( m_preferences, &Preferences::signalNumberAlignmentChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberAlignmentChange );
-        disconnect( m_preferences, &Preferences::signalNumberMarginsChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNumberMarginsChange );
-        disconnect( m_preferences, &Preferences::signalNewIndicatorTypeChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNewIndicatorTypeChange );
-        disconnect( m_preferences, &Preferences::signalNewShadeColorChange, m_kde_tray_icon, &SysTrayXStatusNotifier::slotNewShadeColorChange );
+        disconnect( m_preferences, &Preferences::signalChanged, m_kde_tray_icon, &SysTrayXStatusNotifier::slotPreferencesChanged );
 
         disconnect( m_link, &SysTrayXLink::signalMailCount, m_kde_tray_icon, &SysTrayXStatusNotifier::slotMailCount );
 
@@ -527,7 +539,7 @@ void    SysTrayX::slotSelectIconObject( bool state )
     if( state )
     {
         //  Use the KDE icon object
-//        emit signalConsole("Enable KDE icon");
+//        LOG_DEBUG("Enable KDE icon");
 
         //  Remove the Qt tray icon
         hideTrayIcon();
@@ -538,7 +550,7 @@ void    SysTrayX::slotSelectIconObject( bool state )
     else
     {
         //  Use default Qt system tray icon
-//        emit signalConsole("Enable Qt icon");
+//        LOG_DEBUG("Enable Qt icon");
 
         //  Remove KDE trsy icon
         hideKdeTrayIcon();
@@ -568,6 +580,180 @@ void    SysTrayX::resendMailCount()
 }
 
 
+/*
+ *  Create and connect the debug window
+ */
+void    SysTrayX::createDebugWidget()
+{
+    m_debug = new DebugWidget( m_preferences );
+    m_debug->setMailCount( m_unread_mail, m_new_mail );
+
+    /*
+     *  Connect debug link signals
+     */
+    connect( m_link, &SysTrayXLink::signalMailCount, m_debug, &DebugWidget::slotMailCount );
+
+    connect( m_debug, &DebugWidget::signalTest1ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest1 );
+    connect( m_debug, &DebugWidget::signalTest2ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest2 );
+    connect( m_debug, &DebugWidget::signalTest3ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest3 );
+    connect( m_debug, &DebugWidget::signalTest4ButtonClicked, m_win_ctrl, &WindowCtrl::slotWindowTest4 );
+    connect( m_debug, &DebugWidget::signalStatsButtonClicked, m_win_ctrl, &WindowCtrl::slotDumpStats );
+
+    connect( m_preferences, &Preferences::signalChanged, m_debug, &DebugWidget::slotPreferencesChanged );
+
+    m_debug->setVisible( m_preferences->getDebug() );
+}
+
+
+/*
+ *  Set the log level
+ */
+void    SysTrayX::setLogLevel()
+{
+    if( m_preferences->getDebug() || m_log_sink )
+    {
+        Logger::setLevel( Logger::LEVEL_DEBUG );
+    }
+    else
+    if( m_startup_trace )
+    {
+        Logger::setLevel( Logger::LEVEL_INFO );
+    }
+    else
+    {
+        /*
+         *  Only the warnings and errors
+         */
+        Logger::setLevel( Logger::LEVEL_WARNING );
+    }
+}
+
+
+/*
+ *  Handle a debug state change
+ */
+void    SysTrayX::slotDebugChange()
+{
+    setLogLevel();
+
+    if( m_debug == nullptr && m_preferences->getDebug() )
+    {
+        createDebugWidget();
+    }
+}
+
+
+/*
+ *  Create and show the preferences dialog
+ */
+void    SysTrayX::slotShowPreferencesDialog()
+{
+    if( m_pref_dialog == nullptr )
+    {
+        m_pref_dialog = new PreferencesDialog( m_link, m_preferences );
+
+        /*
+         *  Connect the dialog, the connections are removed when it is closed
+         */
+        connect( m_preferences, &Preferences::signalChanged, m_pref_dialog, &PreferencesDialog::slotPreferencesChanged );
+        connect( m_pref_dialog, &PreferencesDialog::signalPreferencesChanged, m_link, &SysTrayXLink::slotPreferencesChanged );
+        connect( m_pref_dialog, &QObject::destroyed, this, &SysTrayX::slotPreferencesDialogDestroyed );
+    }
+
+    m_pref_dialog->slotShowDialog();
+}
+
+
+/*
+ *  The preferences dialog has been closed
+ */
+void    SysTrayX::slotPreferencesDialogDestroyed()
+{
+    m_pref_dialog = nullptr;
+}
+
+
+/*
+ *  Handle a preferences change set
+ */
+void    SysTrayX::slotPreferencesChanged( Preferences::ChangeSet changes )
+{
+    const Preferences::ChangeSet window_ctrl_changes = Preferences::CHANGE_MINIMIZE_TYPE |
+            Preferences::CHANGE_MINIMIZE_ICON_TYPE | Preferences::CHANGE_CLOSE_TYPE |
+            Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION | Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION_TYPE;
+
+    Preferences::ChangeSet window_changes = changes & window_ctrl_changes;
+    if( window_changes != Preferences::ChangeSet() )
+    {
+        emit signalWindowCtrlPreferences( window_changes, m_preferences->getWindowSettings() );
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_DEBUG ) )
+    {
+        slotDebugChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_HIDE_DEFAULT_ICON ) )
+    {
+        slotSelectIconObjectPref();
+    }
+
+#if defined( SHORTCUTS )
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_HIDE_SHORTCUT ) && m_preferences->getShortcutsOption() )
+    {
+        slotShowHideShortcutChange();
+    }
+
+#endif
+}
+
+
+/*
+ *  Report the time spent in a startup phase
+ */
+void    SysTrayX::traceStartup( const QString& phase )
+{
+    if( !m_startup_trace )
+    {
+        return;
+    }
+
+    qint64 now = m_startup_clock.nsecsElapsed() / 1000;
+
+    /*
+     *  Never on stdout, that is the link to the add-on
+     */
+    QString message = QString( "Startup %1: %2 ms (+%3 ms)" )
+            .arg( phase )
+            .arg( now / 1000.0, 0, 'f', 2 )
+            .arg( ( now - m_startup_mark ) / 1000.0, 0, 'f', 2 );
+    fprintf( stderr, "%s\n", message.toLocal8Bit().constData() );
+
+    LOG_INFO( message );
+
+    m_startup_mark = now;
+}
+
+
+/*
+ *  Handle the preferences from the add-on
+ */
+void    SysTrayX::slotPreferencesReceived()
+{
+    /*
+     *  Remember the icon preferences for the next start
+     */
+    m_preferences->saveSnapshot();
+
+    if( !m_startup_handshake )
+    {
+        m_startup_handshake = true;
+        traceStartup( "handshake" );
+    }
+}
+
+
 /*
  *  Quit the app by add-on request
  */
@@ -739,7 +925,7 @@ void    SysTrayX::slotLoadLanguage( QString locale )
         QString locale_path = "SysTray-X."+ locale;
         (void)m_translator.load( locale_path, ":/languages/" );
 //        bool status = m_translator.load( locale_path, ":/languages/" );
-//        emit signalConsole( QString( "Language loaded %1").arg(status));
+//        LOG_DEBUG( QString( "Language loaded %1").arg(status));
         qApp->installTranslator( &m_translator );
     }
 }
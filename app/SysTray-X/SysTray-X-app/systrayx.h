@@ -14,13 +14,21 @@
 #include <QObject>
 #include <QTranslator>
 #include <QSystemTrayIcon>
+#include <QElapsedTimer>
+
+/*
+ *  Environment variable to enable the startup trace
+ */
+#define STARTUP_TRACE_ENV   "SYSTRAYX_STARTUP_TRACE"
 
 /*
  *	Predefines
  */
 class QAction;
+class QThread;
 
 class DebugWidget;
+class LoggerFileSink;
 class PreferencesDialog;
 class SysTrayXIcon;
 class SysTrayXLink;
@@ -50,6 +58,7 @@ class SysTrayX : public QObject
          *  @param parent   My parent.
          */
         explicit SysTrayX( QObject *parent = nullptr );
+        ~SysTrayX();
 
     private:
 
@@ -97,6 +106,23 @@ class SysTrayX : public QObject
          */
         void    resendMailCount();
 
+        /**
+         * @brief createDebugWidget. Create and connect the debug window.
+         */
+        void    createDebugWidget();
+
+        /**
+         * @brief setLogLevel. Set the log level for the debug state and the log file.
+         */
+        void    setLogLevel();
+
+        /**
+         * @brief traceStartup. Report the time spent in a startup phase.
+         *
+         *  @param phase    The phase.
+         */
+        void    traceStartup( const QString& phase );
+
     signals:
 
         /**
@@ -120,11 +146,12 @@ class SysTrayX : public QObject
         void    signalClose();
 
         /**
-         * @brief signalConsole. Send a console message.
+         * @brief signalWindowCtrlPreferences. Signal the changed window control preferences.
          *
-         *  @param message      The message.
+         *  @param changes      The changed preferences.
+         *  @param settings     Copy of the window control preferences.
          */
-        void    signalConsole( QString message );
+        void    signalWindowCtrlPreferences( Preferences::ChangeSet changes, Preferences::WindowSettings settings );
 
     public slots:
 
@@ -193,6 +220,33 @@ class SysTrayX : public QObject
          */
         void    slotShowHideShortcutChange();
 
+        /**
+         * @brief slotDebugChange. Create the debug window when debugging is enabled.
+         */
+        void    slotDebugChange();
+
+        /**
+         * @brief slotShowPreferencesDialog. Create and show the preferences dialog.
+         */
+        void    slotShowPreferencesDialog();
+
+        /**
+         * @brief slotPreferencesDialogDestroyed. The preferences dialog has been closed.
+         */
+        void    slotPreferencesDialogDestroyed();
+
+        /**
+         * @brief slotPreferencesChanged. Handle a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         */
+        void    slotPreferencesChanged( Preferences::ChangeSet changes );
+
+        /**
+         * @brief slotPreferencesReceived. Handle the preferences from the add-on.
+         */
+        void    slotPreferencesReceived();
+
     private:
 
         /**
@@ -205,18 +259,28 @@ class SysTrayX : public QObject
          */
         DebugWidget*    m_debug;
 
+        /**
+         * @brief m_log_sink. Pointer to the log file sink, only when requested.
+         */
+        LoggerFileSink* m_log_sink;
+
         /**
          * @brief m_win_ctrl. Pointer to the window control.
          */
         WindowCtrl*     m_win_ctrl;
 
+        /**
+         * @brief m_win_ctrl_thread. Pointer to the window control thread.
+         */
+        QThread*    m_win_ctrl_thread;
+
         /**
          * @brief m_link. Pointer to the link object.
          */
         SysTrayXLink*   m_link;
 
         /**
-         * @brief m_pref_dialog. Pointer to the preferences dialog.
+         * @brief m_pref_dialog. Pointer to the preferences dialog, only while it is open.
          */
         PreferencesDialog*  m_pref_dialog;
 
@@ -267,6 +331,31 @@ class SysTrayX : public QObject
          * @brief m_show_hide_shortcut. Storage for the show / hide shortcut.
          */
         Shortcut* m_show_hide_shortcut;
+
+        /**
+         * @brief m_startup_trace. Report the startup phases.
+         */
+        bool    m_startup_trace;
+
+        /**
+         * @brief m_startup_clock. Time since the start of the app.
+         */
+        QElapsedTimer   m_startup_clock;
+
+        /**
+         * @brief m_startup_mark. End of the last traced phase (us).
+         */
+        qint64  m_startup_mark;
+
+        /**
+         * @brief m_startup_icon. The first icon has been shown.
+         */
+        bool    m_startup_icon;
+
+        /**
+         * @brief m_startup_handshake. The first preferences have been received.
+         */
+        bool    m_startup_handshake;
 };
 
 #endif // SYSTRAYX_H
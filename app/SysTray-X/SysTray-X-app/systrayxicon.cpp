@@ -4,6 +4,7 @@
  *	Local includes
  */
 #include "preferences.h"
+#include "tracer.h"
 
 /*
  *  System includes
@@ -31,6 +32,10 @@ SysTrayXIcon::SysTrayXIcon( SysTrayXLink* link, Preferences* pref, QObject* pare
     m_unread_mail = 0;
     m_new_mail = 0;
 
+    m_render_batch = false;
+    m_render_base_pending = false;
+    m_render_icon_pending = false;
+
     m_pixmap_clean = QPixmap();
     m_pixmap_count = QPixmap();
     m_image_indicator = QImage();
@@ -394,6 +399,14 @@ void    SysTrayXIcon::setMailCount( int unread_mail, int new_mail )
  */
 void    SysTrayXIcon::renderBase()
 {
+    if( m_render_batch )
+    {
+        m_render_base_pending = true;
+        return;
+    }
+
+    TraceSpan span( "Icon base render", "icon" );
+
     /*
      * Set the clean icon
      */
@@ -564,6 +577,14 @@ void    SysTrayXIcon::indicator( QPixmap& pixmap )
  */
 void    SysTrayXIcon::renderIcon()
 {
+    if( m_render_batch )
+    {
+        m_render_icon_pending = true;
+        return;
+    }
+
+    TraceSpan span( "Icon render", "icon" );
+
     QPixmap pixmap;
     int count;
 
@@ -626,7 +647,11 @@ void    SysTrayXIcon::renderIcon()
     /*
      *  Set the tray icon
      */
-    QSystemTrayIcon::setIcon( QIcon( pixmap ) );
+    {
+        TraceSpan tray_span( "Tray update", "tray" );
+
+        QSystemTrayIcon::setIcon( QIcon( pixmap ) );
+    }
 }
 
 
@@ -639,6 +664,97 @@ void    SysTrayXIcon::slotMailCount( int unread_mail, int new_mail )
 }
 
 
+/*
+ *  Handle a preferences change set
+ */
+void    SysTrayXIcon::slotPreferencesChanged( Preferences::ChangeSet changes )
+{
+    /*
+     *  Render once for the whole change set
+     */
+    m_render_batch = true;
+
+    if( changes.testFlag( Preferences::CHANGE_DEFAULT_ICON_TYPE ) )
+    {
+        slotDefaultIconTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_DEFAULT_ICON_DATA ) )
+    {
+        slotDefaultIconDataChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_ICON_TYPE ) )
+    {
+        slotIconTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_ICON_DATA ) )
+    {
+        slotIconDataChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_INVERT_ICON ) )
+    {
+        slotInvertIconChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_NUMBER ) )
+    {
+        slotShowNumberChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_SHOW_NEW_INDICATOR ) )
+    {
+        slotShowNewIndicatorChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_COLOR ) )
+    {
+        slotNumberColorChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_SIZE ) )
+    {
+        slotNumberSizeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_ALIGNMENT ) )
+    {
+        slotNumberAlignmentChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NUMBER_MARGINS ) )
+    {
+        slotNumberMarginsChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NEW_INDICATOR_TYPE ) )
+    {
+        slotNewIndicatorTypeChange();
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_NEW_SHADE_COLOR ) )
+    {
+        slotNewShadeColorChange();
+    }
+
+    m_render_batch = false;
+
+    if( m_render_base_pending )
+    {
+        m_render_base_pending = false;
+        renderBase();
+    }
+
+    if( m_render_icon_pending )
+    {
+        m_render_icon_pending = false;
+        renderIcon();
+    }
+}
+
+
 /*
  *  Handle the default icon type change signal
  */
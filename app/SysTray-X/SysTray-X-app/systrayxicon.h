@@ -182,6 +182,13 @@ class SysTrayXIcon : public QSystemTrayIcon
          */
         void    slotMailCount( int unread_mail, int new_mail );
 
+        /**
+         * @brief slotPreferencesChanged. Slot for handling a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         */
+        void    slotPreferencesChanged( Preferences::ChangeSet changes );
+
         /**
          * @brief slotDefaultIconTypeChange. Slot for handling default icon type change signals.
          */
@@ -363,6 +370,21 @@ class SysTrayXIcon : public QSystemTrayIcon
          * @brief m_new_mail. Storage for the number of new mails.
          */
         int m_new_mail;
+
+        /**
+         * @brief m_render_batch. Defer rendering while handling a change set.
+         */
+        bool    m_render_batch;
+
+        /**
+         * @brief m_render_base_pending. The base pixmaps need rendering after the change set.
+         */
+        bool    m_render_base_pending;
+
+        /**
+         * @brief m_render_icon_pending. The icon needs rendering after the change set.
+         */
+        bool    m_render_icon_pending;
 };
 
 #endif // SYSTRAYXICON_H
@@ -5,6 +5,8 @@
  *	Local includes
  */
 #include "preferences.h"
+#include "logger.h"
+#include "tracer.h"
 
 
 /*
@@ -114,6 +116,8 @@ void    SysTrayXLinkReader::slotWorker()
 
         if( data_len > 0)
         {
+            TraceSpan span( "Link read", "link" );
+
             QByteArray data( data_len, 0 );
             std::cin.read( data.data(), data_len );
 
@@ -162,6 +166,17 @@ SysTrayXLink::SysTrayXLink( Preferences* pref )
      */
     m_pref = pref;
 
+    /*
+     *  Hold back the messages until the add-on sent its initial state
+     */
+    m_handshake = false;
+    m_hello = false;
+
+    m_handshake_timer = new QTimer( this );
+    m_handshake_timer->setSingleShot( true );
+    connect( m_handshake_timer, &QTimer::timeout, this, &SysTrayXLink::slotHandshakeTimeout );
+    m_handshake_timer->start( HANDSHAKE_TIMEOUT );
+
     /*
      *  Open dump.txt
      */
@@ -172,6 +187,7 @@ SysTrayXLink::SysTrayXLink( Preferences* pref )
      *  Setup the reader thread
      */
     m_reader_thread = new QThread( this );
+    m_reader_thread->setObjectName( "Link reader" );
 
     SysTrayXLinkReader* reader = new SysTrayXLinkReader;
     reader->moveToThread( m_reader_thread );
@@ -226,6 +242,26 @@ void    SysTrayXLink::sendPreferences()
 }
 
 
+/*
+ *  Request the icon data from the add-on
+ */
+void    SysTrayXLink::sendIconRequest()
+{
+    QJsonObject requestObject;
+    requestObject.insert( "iconRequest", QJsonValue::fromVariant( true ) );
+
+    /*
+     *  Store the new document
+     */
+    QJsonDocument json_doc = QJsonDocument( requestObject );
+
+    /*
+     *  Send it to the add-on
+     */
+    linkWrite( json_doc.toJson( QJsonDocument::Compact ) );
+}
+
+
 /*
  *  Send shutdown to the add-on
  */
@@ -251,12 +287,32 @@ void    SysTrayXLink::sendShutdown()
  */
 void    SysTrayXLink::sendOptions()
 {
-    QJsonObject options_object;
-    options_object.insert("kdeIntegration", QJsonValue::fromVariant( m_pref->getKdeIntegrationOption() ) );
-    options_object.insert("shortcuts", QJsonValue::fromVariant( m_pref->getShortcutsOption() ) );
+    QJsonObject main_object;
+    main_object.insert("options", EncodeOptions() );
+
+    /*
+     *  Store the new document
+     */
+    QJsonDocument json_doc = QJsonDocument( main_object );
+
+    /*
+     *  Send it to the add-on
+     */
+    linkWrite( json_doc.toJson( QJsonDocument::Compact ) );
+}
+
+
+/*
+ *  Answer the startup handshake of the add-on
+ */
+void    SysTrayXLink::sendHello()
+{
+    QJsonObject hello_object;
+    hello_object.insert("protocol", HELLO_PROTOCOL );
+    hello_object.insert("options", EncodeOptions() );
 
     QJsonObject main_object;
-    main_object.insert("options", options_object);
+    main_object.insert("hello", hello_object);
 
     /*
      *  Store the new document
@@ -301,11 +357,33 @@ void    SysTrayXLink::sendPositions( QList< QPoint > positions )
 }
 
 
+/*
+ *  Send the window identified to the add-on
+ */
+void    SysTrayXLink::sendWindowIdentified( int id )
+{
+    QJsonObject identifiedObject;
+    identifiedObject.insert("windowIdentified", id );
+
+    /*
+     *  Store the new document
+     */
+    QJsonDocument json_doc = QJsonDocument( identifiedObject );
+
+    /*
+     *  Send it to the add-on
+     */
+    linkWrite( json_doc.toJson( QJsonDocument::Compact ) );
+}
+
+
 /*
  *  Decode JSON message
  */
 void    SysTrayXLink::DecodeMessage( const QByteArray& message )
 {
+    TraceSpan span( "Link decode", "link" );
+
     QJsonParseError jsonError;
     QJsonDocument jsonResponse = QJsonDocument::fromJson( message, &jsonError );
 
@@ -317,10 +395,48 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
         QStringList list = jsonObject.keys();
         for( int i = 0 ;  i < list.length() ; ++i )
         {
-            emit signalConsole( QString("Message %1").arg(list.at(i)) );
+            LOG_DEBUG( QString("Message %1").arg(list.at(i)) );
         }
 */
 
+        /*
+         *  The add-on starts with a handshake carrying its full initial state
+         */
+        if( jsonObject.contains( "hello" ) && jsonObject[ "hello" ].isObject() )
+        {
+            DecodeHello( jsonObject[ "hello" ].toObject() );
+
+            return;
+        }
+
+        if( !m_handshake )
+        {
+            if( jsonObject.contains( "optionsRequest" ) )
+            {
+                /*
+                 *  An add-on without the handshake, decode as before
+                 */
+                releaseHeldMessages();
+            }
+            else
+            if( isWindowMessage( jsonObject ) )
+            {
+                /*
+                 *  Hold it until the initial state is known
+                 */
+                m_held_messages.append( message );
+
+                if( m_held_messages.length() >= HELD_MESSAGES_MAX )
+                {
+                    LOG_WARNING( QString( "No handshake after %1 messages, releasing them" ).arg( m_held_messages.length() ) );
+
+                    releaseHeldMessages();
+                }
+
+                return;
+            }
+        }
+
         if( jsonObject.contains( "mailCount" ) && jsonObject[ "mailCount" ].isObject() )
         {
             QJsonObject mailCount = jsonObject[ "mailCount" ].toObject();
@@ -362,22 +478,15 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
             emit signalAddOnShutdown();
         }
 
-        if( jsonObject.contains( "startup" ) && jsonObject[ "startup" ].isString() )
-        {
-            QString state_str = jsonObject[ "startup" ].toString();
-
-            Preferences::WindowState window_state;
-            if( state_str == Preferences::STATE_MINIMIZED_STR )
-            {
-                window_state = Preferences::STATE_MINIMIZED_STARTUP;
-            }
-
-            if( state_str == Preferences::STATE_DOCKED_STR )
-            {
-                window_state = Preferences::STATE_DOCKED_STARTUP;
-            }
+        /*
+         *  The startup frames are already part of the hello,
+         *  an add-on not getting the hello answer in time sends them again
+         */
+        bool startup_frames = !m_hello;
 
-            emit signalWindowState( window_state, 0 );
+        if( startup_frames && jsonObject.contains( "startup" ) && jsonObject[ "startup" ].isString() )
+        {
+            DecodeStartup( jsonObject[ "startup" ].toString() );
         }
 
         if( jsonObject.contains( "windows" ) && jsonObject[ "windows" ].isArray() )
@@ -425,7 +534,7 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
             }
         }
 
-        if( jsonObject.contains( "optionsRequest" ) && jsonObject[ "optionsRequest" ].isBool() )
+        if( startup_frames && jsonObject.contains( "optionsRequest" ) && jsonObject[ "optionsRequest" ].isBool() )
         {
             sendOptions();
         }
@@ -457,7 +566,7 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
             DecodeBrowser( jsonObject[ "browserInfo" ].toObject() );
         }
 
-        if( jsonObject.contains( "positions" ) && jsonObject[ "positions" ].isArray() )
+        if( startup_frames && jsonObject.contains( "positions" ) && jsonObject[ "positions" ].isArray() )
         {
             DecodePositions( jsonObject[ "positions" ].toArray() );
         }
@@ -465,9 +574,11 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
         if( jsonObject.contains( "preferences" ) && jsonObject[ "preferences" ].isObject() )
         {
             DecodePreferences( jsonObject[ "preferences" ].toObject() );
+
+            emit signalPreferencesReceived();
         }
 
-        if( jsonObject.contains( "startApp" ) && jsonObject[ "startApp" ].isString() &&
+        if( startup_frames && jsonObject.contains( "startApp" ) && jsonObject[ "startApp" ].isString() &&
             jsonObject.contains( "startAppArgs" ) && jsonObject[ "startAppArgs" ].isString() )
         {
             QString app = jsonObject[ "startApp" ].toString();
@@ -491,7 +602,26 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
         {
             int new_window_id = jsonObject[ "newWindow" ].toInt();
 
-            emit signalNewWindow( new_window_id );
+            emit signalNewWindow( new_window_id, QString() );
+        }
+
+        if( jsonObject.contains( "newWindow" ) && jsonObject[ "newWindow" ].isObject() )
+        {
+            QJsonObject new_window = jsonObject[ "newWindow" ].toObject();
+
+            int new_window_id = 0;
+            if( new_window.contains( "id" ) && new_window[ "id" ].isDouble() )
+            {
+                new_window_id = new_window[ "id" ].toInt();
+            }
+
+            QString new_window_token;
+            if( new_window.contains( "token" ) && new_window[ "token" ].isString() )
+            {
+                new_window_token = new_window[ "token" ].toString();
+            }
+
+            emit signalNewWindow( new_window_id, new_window_token );
         }
 
         if( jsonObject.contains( "closeWindow" ) && jsonObject[ "closeWindow" ].isObject() )
@@ -516,6 +646,154 @@ void    SysTrayXLink::DecodeMessage( const QByteArray& message )
 }
 
 
+/*
+ *  Decode the startup handshake
+ */
+void    SysTrayXLink::DecodeHello( const QJsonObject& hello )
+{
+    m_hello = true;
+
+    int protocol = 0;
+    if( hello.contains( "protocol" ) && hello[ "protocol" ].isDouble() )
+    {
+        protocol = hello[ "protocol" ].toInt();
+    }
+
+    if( protocol != HELLO_PROTOCOL )
+    {
+        LOG_WARNING( QString( "Handshake protocol mismatch: app %1, add-on %2" )
+                .arg( HELLO_PROTOCOL ).arg( protocol ) );
+    }
+
+    if( hello.contains( "locale" ) && hello[ "locale" ].isString() )
+    {
+        emit signalLocale( hello[ "locale" ].toString() );
+    }
+
+    /*
+     *  Apply the full state as one change set, the icon is rendered once
+     */
+    m_pref->beginChanges();
+
+    if( hello.contains( "platformInfo" ) && hello[ "platformInfo" ].isObject() )
+    {
+        DecodePlatform( hello[ "platformInfo" ].toObject() );
+    }
+
+    if( hello.contains( "browserInfo" ) && hello[ "browserInfo" ].isObject() )
+    {
+        DecodeBrowser( hello[ "browserInfo" ].toObject() );
+    }
+
+    bool preferences = hello.contains( "preferences" ) && hello[ "preferences" ].isObject();
+    if( preferences )
+    {
+        DecodePreferences( hello[ "preferences" ].toObject() );
+    }
+
+    m_pref->commitChanges();
+
+    if( hello.contains( "hideDefaultIcon" ) && hello[ "hideDefaultIcon" ].isBool() )
+    {
+        emit signalKdeIntegration( hello[ "hideDefaultIcon" ].toBool() );
+    }
+
+    if( hello.contains( "version" ) && hello[ "version" ].isString() )
+    {
+        emit signalVersion( hello[ "version" ].toString() );
+    }
+
+    if( hello.contains( "positions" ) && hello[ "positions" ].isArray() )
+    {
+        DecodePositions( hello[ "positions" ].toArray() );
+    }
+
+    if( preferences )
+    {
+        emit signalPreferencesReceived();
+
+        /*
+         *  The start application parameters are part of the preferences
+         */
+        emit signalStartApp();
+    }
+
+    /*
+     *  Answer with the options
+     */
+    sendHello();
+
+    /*
+     *  Window actions last, all preferences are known by now
+     */
+    if( hello.contains( "startup" ) && hello[ "startup" ].isString() )
+    {
+        DecodeStartup( hello[ "startup" ].toString() );
+    }
+
+    releaseHeldMessages();
+}
+
+
+/*
+ *  Decode the startup window state
+ */
+void    SysTrayXLink::DecodeStartup( const QString& state )
+{
+    Preferences::WindowState window_state;
+    if( state == Preferences::STATE_MINIMIZED_STR )
+    {
+        window_state = Preferences::STATE_MINIMIZED_STARTUP;
+    }
+    else
+    if( state == Preferences::STATE_DOCKED_STR )
+    {
+        window_state = Preferences::STATE_DOCKED_STARTUP;
+    }
+    else
+    {
+        /*
+         *  Unknown state
+         */
+        return;
+    }
+
+    emit signalWindowState( window_state, 0 );
+}
+
+
+/*
+ *  End the handshake, decode the messages held back
+ */
+void    SysTrayXLink::releaseHeldMessages()
+{
+    m_handshake = true;
+    m_handshake_timer->stop();
+
+    QList< QByteArray > held_messages = m_held_messages;
+    m_held_messages.clear();
+
+    for( int i = 0 ; i < held_messages.length() ; ++i )
+    {
+        DecodeMessage( held_messages.at( i ) );
+    }
+}
+
+
+/*
+ *  Does the message render the icon or act on the windows
+ */
+bool    SysTrayXLink::isWindowMessage( const QJsonObject& message ) const
+{
+    return message.contains( "mailCount" ) ||
+            message.contains( "windows" ) ||
+            message.contains( "startup" ) ||
+            message.contains( "positions" ) ||
+            message.contains( "newWindow" ) ||
+            message.contains( "closeWindow" );
+}
+
+
 /*
  *  Decode platform from JSON message
  */
@@ -646,6 +924,11 @@ void    SysTrayXLink::DecodePositions( const QJsonArray& positions )
  */
 void    SysTrayXLink::DecodePreferences( const QJsonObject& pref )
 {
+    /*
+     *  Collect all changes, the subscribers get one change set
+     */
+    m_pref->beginChanges();
+
     if( pref.contains( "debug" ) && pref[ "debug" ].isString() )
     {
         bool debug = pref[ "debug" ].toString() == "true";
@@ -799,6 +1082,25 @@ void    SysTrayXLink::DecodePreferences( const QJsonObject& pref )
         m_pref->setIconData( QByteArray::fromBase64( icon_base64.toUtf8() ) );
     }
 
+    /*
+     *  Icons sent by hash only, request the data when the cached icons differ
+     */
+    bool request_icons = false;
+    if( !pref.contains( "defaultIcon" ) && pref.contains( "defaultIconHash" ) && pref[ "defaultIconHash" ].isString() )
+    {
+        request_icons |= pref[ "defaultIconHash" ].toString() != m_pref->getDefaultIconHash();
+    }
+
+    if( !pref.contains( "icon" ) && pref.contains( "iconHash" ) && pref[ "iconHash" ].isString() )
+    {
+        request_icons |= pref[ "iconHash" ].toString() != m_pref->getIconHash();
+    }
+
+    if( request_icons )
+    {
+        sendIconRequest();
+    }
+
     if( pref.contains( "invertIcon" ) && pref[ "invertIcon" ].isString() )
     {
         bool invert_icon = pref[ "invertIcon" ].toString() == "true";
@@ -968,6 +1270,8 @@ void    SysTrayXLink::DecodePreferences( const QJsonObject& pref )
          */
         m_pref->setShowHideShortcut( QKeySequence::fromString( shortcut ) );
     }
+
+    m_pref->commitChanges();
 }
 
 
@@ -1060,6 +1364,19 @@ void    SysTrayXLink::EncodePreferences( const Preferences& pref )
 }
 
 
+/*
+ *  Encode the app options
+ */
+QJsonObject SysTrayXLink::EncodeOptions()
+{
+    QJsonObject options_object;
+    options_object.insert("kdeIntegration", QJsonValue::fromVariant( m_pref->getKdeIntegrationOption() ) );
+    options_object.insert("shortcuts", QJsonValue::fromVariant( m_pref->getShortcutsOption() ) );
+
+    return options_object;
+}
+
+
 /*
  *  Relay shutdown signal
  */
@@ -1069,6 +1386,22 @@ void    SysTrayXLink::slotErrorAddOnShutdown()
 }
 
 
+/*
+ *  Handle a missing handshake
+ */
+void    SysTrayXLink::slotHandshakeTimeout()
+{
+    if( m_handshake )
+    {
+        return;
+    }
+
+    LOG_WARNING( QString( "No handshake from the add-on, releasing %1 held messages" ).arg( m_held_messages.length() ) );
+
+    releaseHeldMessages();
+}
+
+
 /*
  *  Read the input
  */
@@ -1090,6 +1423,15 @@ void    SysTrayXLink::slotPositions( QList< QPoint > positions )
 }
 
 
+/*
+ *  Handle a window identified signal
+ */
+void    SysTrayXLink::slotWindowIdentified( int id )
+{
+    sendWindowIdentified( id );
+}
+
+
 /*
  *  Handle a preferences changed signal
  */
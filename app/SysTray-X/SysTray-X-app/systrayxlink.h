@@ -14,6 +14,22 @@
 #include <QJsonDocument>
 #include <QList>
 #include <QPoint>
+#include <QJsonObject>
+
+/*
+ *  Version of the startup handshake with the add-on
+ */
+#define HELLO_PROTOCOL  1
+
+/*
+ *  Time to hold the window messages waiting for the handshake (ms)
+ */
+#define HANDSHAKE_TIMEOUT   10000
+
+/*
+ *  Maximum number of window messages held waiting for the handshake
+ */
+#define HELD_MESSAGES_MAX   100
 
 /*
  *	Predefines
@@ -115,11 +131,21 @@ class SysTrayXLink : public QObject
          */
         void    sendShutdown();
 
+        /**
+         * @brief sendIconRequest. Request the icon data from the add-on.
+         */
+        void    sendIconRequest();
+
         /**
          * @brief sendOptions. Send the options to the add-on.
          */
         void    sendOptions();
 
+        /**
+         * @brief sendHello. Answer the startup handshake of the add-on.
+         */
+        void    sendHello();
+
         /**
          * @brief sendPositions
          *
@@ -127,6 +153,13 @@ class SysTrayXLink : public QObject
          */
         void    sendPositions( QList< QPoint > positions );
 
+        /**
+         * @brief sendWindowIdentified. Tell the add-on the window has been matched.
+         *
+         * @param id    TB id of the window.
+         */
+        void    sendWindowIdentified( int id );
+
     private:
 
         /**
@@ -136,6 +169,34 @@ class SysTrayXLink : public QObject
          */
         void    DecodeMessage( const QByteArray& message );
 
+        /**
+         * @brief DecodeHello. Decode the startup handshake, the full initial state of the add-on.
+         *
+         * @param hello     The JSON hello.
+         */
+        void    DecodeHello( const QJsonObject& hello );
+
+        /**
+         * @brief DecodeStartup. Decode the startup window state.
+         *
+         * @param state     The startup state.
+         */
+        void    DecodeStartup( const QString& state );
+
+        /**
+         * @brief releaseHeldMessages. End the handshake and decode the messages held back.
+         */
+        void    releaseHeldMessages();
+
+        /**
+         * @brief isWindowMessage. Does the message render the icon or act on the windows.
+         *
+         * @param message   The JSON message.
+         *
+         * @return  True if it has to wait for the initial state.
+         */
+        bool    isWindowMessage( const QJsonObject& message ) const;
+
         /**
          * @brief DecodePlatform. Decode a JSON platform object.
          *
@@ -180,14 +241,14 @@ class SysTrayXLink : public QObject
          */
         void    EncodePreferences( const Preferences& pref );
 
-    signals:
-
         /**
-         * @brief signalConsole. Send a console message.
+         * @brief EncodeOptions. Encode the app options.
          *
-         *  @param message      The message.
+         * @return  The JSON options.
          */
-        void    signalConsole( QString message );
+        QJsonObject EncodeOptions();
+
+    signals:
 
         /**
          * @brief signalTitle. Signal the title.
@@ -241,6 +302,11 @@ class SysTrayXLink : public QObject
          */
         void    signalWindowPositions( QList< QPoint > window_positions );
 
+        /**
+         * @brief signalPreferencesReceived. Signal the preferences from the add-on have been decoded.
+         */
+        void    signalPreferencesReceived();
+
         /**
          * @brief signalStartApp. Signal the start app launch request.
          */
@@ -254,9 +320,10 @@ class SysTrayXLink : public QObject
         /**
          * @brief signalNewWindow. Signal the new window id.
          *
-         *  @param id   TB id of the window.
+         *  @param id       TB id of the window.
+         *  @param token    Token in the window title, empty if not stamped.
          */
-        void    signalNewWindow( int id );
+        void    signalNewWindow( int id, QString token );
 
         /**
          * @brief signalCloseWindow. Signal the close window id.
@@ -273,6 +340,13 @@ class SysTrayXLink : public QObject
          */
         void    slotPositions( QList< QPoint > positions );
 
+        /**
+         * @brief slotWindowIdentified. Slot for handling a matched window.
+         *
+         *  @param id   TB id of the window.
+         */
+        void    slotWindowIdentified( int id );
+
         /**
          * @brief slotPreferencesChanged
          */
@@ -290,6 +364,11 @@ class SysTrayXLink : public QObject
          */
         void    slotErrorAddOnShutdown();
 
+        /**
+         * @brief slotHandshakeTimeout. Handle a missing handshake.
+         */
+        void    slotHandshakeTimeout();
+
     private:
 
         /**
@@ -306,6 +385,26 @@ class SysTrayXLink : public QObject
          * @brief m_pref_json_doc. Temporary storage for the preferences to be send.
          */
         QJsonDocument   m_pref_json_doc;
+
+        /**
+         * @brief m_handshake. The startup handshake with the add-on is done.
+         */
+        bool    m_handshake;
+
+        /**
+         * @brief m_hello. The add-on sent its initial state in a hello.
+         */
+        bool    m_hello;
+
+        /**
+         * @brief m_held_messages. Messages received before the handshake.
+         */
+        QList< QByteArray > m_held_messages;
+
+        /**
+         * @brief m_handshake_timer. Bounds the time messages are held.
+         */
+        QTimer* m_handshake_timer;
 };
 
 #endif // SYSTRAYXLINK_H
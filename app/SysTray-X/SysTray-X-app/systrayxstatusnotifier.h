@@ -200,6 +200,13 @@ class SysTrayXStatusNotifier : public KStatusNotifierItem
          */
         void    slotMailCount( int unread_mail, int new_mail );
 
+        /**
+         * @brief slotPreferencesChanged. Slot for handling a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         */
+        void    slotPreferencesChanged( Preferences::ChangeSet changes );
+
         /**
          * @brief slotDefaultIconTypeChange. Slot for handling default icon type change signals.
          */
@@ -398,6 +405,21 @@ class SysTrayXStatusNotifier : public KStatusNotifierItem
          * @brief m_new_mail. Storage for the number of new mails.
          */
         int m_new_mail;
+
+        /**
+         * @brief m_render_batch. Defer rendering while handling a change set.
+         */
+        bool    m_render_batch;
+
+        /**
+         * @brief m_render_base_pending. The base pixmaps need rendering after the change set.
+         */
+        bool    m_render_base_pending;
+
+        /**
+         * @brief m_render_icon_pending. The icon needs rendering after the change set.
+         */
+        bool    m_render_icon_pending;
 };
 
 #endif // SYSTRAYXSTATUSNOTIFIER_H
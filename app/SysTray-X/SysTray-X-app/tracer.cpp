@@ -0,0 +1,221 @@
+#include "tracer.h"
+
+/*
+ *	Local includes
+ */
+#include "logger.h"
+
+/*
+ *	System includes
+ */
+
+/*
+ *	Qt includes
+ */
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+
+/*
+ *  Storage
+ */
+std::atomic< bool > Tracer::m_enabled( false );
+QString Tracer::m_path;
+QElapsedTimer   Tracer::m_clock;
+QMutex  Tracer::m_mutex;
+QVector< Tracer::Event >    Tracer::m_events;
+QMap< int, QString >    Tracer::m_threads;
+int Tracer::m_dropped = 0;
+
+
+/*
+ *  Start recording
+ */
+void    Tracer::start( const QString& path )
+{
+    QMutexLocker lock( &m_mutex );
+
+    m_path = path;
+    m_events.clear();
+    m_dropped = 0;
+
+    m_clock.start();
+
+    m_enabled.store( true, std::memory_order_release );
+}
+
+
+/*
+ *  Stop recording and write the trace file
+ */
+void    Tracer::stop()
+{
+    if( !m_enabled.exchange( false ) )
+    {
+        return;
+    }
+
+    QMutexLocker lock( &m_mutex );
+
+    QFile file( m_path );
+    if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        LOG_WARNING( QString( "Cannot write trace file: %1" ).arg( m_path ) );
+
+        return;
+    }
+
+    qint64 pid = QCoreApplication::applicationPid();
+
+    file.write( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+    /*
+     *  Name the process and the threads
+     */
+    QJsonObject process_args;
+    process_args.insert( "name", "SysTray-X" );
+
+    QJsonObject process_object;
+    process_object.insert( "name", "process_name" );
+    process_object.insert( "ph", "M" );
+    process_object.insert( "pid", pid );
+    process_object.insert( "args", process_args );
+
+    file.write( QJsonDocument( process_object ).toJson( QJsonDocument::Compact ) );
+
+    QMap< int, QString >::const_iterator thread;
+    for( thread = m_threads.constBegin() ; thread != m_threads.constEnd() ; ++thread )
+    {
+        QJsonObject thread_args;
+        thread_args.insert( "name", thread.value() );
+
+        QJsonObject thread_object;
+        thread_object.insert( "name", "thread_name" );
+        thread_object.insert( "ph", "M" );
+        thread_object.insert( "pid", pid );
+        thread_object.insert( "tid", thread.key() );
+        thread_object.insert( "args", thread_args );
+
+        file.write( ",\n" );
+        file.write( QJsonDocument( thread_object ).toJson( QJsonDocument::Compact ) );
+    }
+
+    /*
+     *  The spans
+     */
+    for( int i = 0 ; i < m_events.length() ; ++i )
+    {
+        const Event& event = m_events.at( i );
+
+        QJsonObject event_object;
+        event_object.insert( "name", event.name );
+        event_object.insert( "cat", event.category );
+        event_object.insert( "ph", "X" );
+        event_object.insert( "ts", event.start );
+        event_object.insert( "dur", event.duration );
+        event_object.insert( "pid", pid );
+        event_object.insert( "tid", event.thread );
+
+        file.write( ",\n" );
+        file.write( QJsonDocument( event_object ).toJson( QJsonDocument::Compact ) );
+    }
+
+    file.write( "\n]}\n" );
+    file.close();
+
+    if( m_dropped > 0 )
+    {
+        LOG_WARNING( QString( "Trace full, %1 spans dropped" ).arg( m_dropped ) );
+    }
+
+    m_events.clear();
+}
+
+
+/*
+ *  Get the trace time
+ */
+qint64  Tracer::now()
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+
+/*
+ *  Record a span
+ */
+void    Tracer::complete( const QString& name, const char* category, qint64 start, qint64 duration )
+{
+    if( !isEnabled() )
+    {
+        return;
+    }
+
+    QMutexLocker lock( &m_mutex );
+
+    if( m_events.length() >= TRACE_MAX_EVENTS )
+    {
+        ++m_dropped;
+
+        return;
+    }
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.duration = duration;
+    event.thread = threadId();
+
+    m_events.append( event );
+}
+
+
+/*
+ *  Get the trace id of the current thread, call with the mutex locked
+ */
+int Tracer::threadId()
+{
+    static thread_local int thread_id = 0;
+
+    if( thread_id == 0 )
+    {
+        thread_id = m_threads.count() + 1;
+
+        QString name = QThread::currentThread()->objectName();
+        if( name.isEmpty() )
+        {
+            name = QString( "Thread %1" ).arg( thread_id );
+        }
+
+        m_threads.insert( thread_id, name );
+    }
+
+    return thread_id;
+}
+
+
+/*
+ *  Constructor, start the span
+ */
+TraceSpan::TraceSpan( const char* name, const char* category )
+{
+    m_name = name;
+    m_category = category;
+    m_start = Tracer::isEnabled() ? Tracer::now() : -1;
+}
+
+
+/*
+ *  Destructor, record the span
+ */
+TraceSpan::~TraceSpan()
+{
+    if( m_start >= 0 && Tracer::isEnabled() )
+    {
+        Tracer::complete( QString::fromLatin1( m_name ), m_category, m_start, Tracer::now() - m_start );
+    }
+}
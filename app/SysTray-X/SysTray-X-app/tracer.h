@@ -0,0 +1,177 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+/*
+ *	Local includes
+ */
+
+/*
+ *	Qt includes
+ */
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/*
+ *  System includes
+ */
+#include <atomic>
+
+/*
+ *  Environment variable with the path of the trace file
+ */
+#define TRACE_ENV           "SYSTRAYX_TRACE"
+
+/*
+ *  Command line argument to enable the trace, --trace=<path>
+ */
+#define TRACE_ARGUMENT      "--trace="
+
+/*
+ *  Maximum number of recorded spans, later spans are dropped
+ */
+#define TRACE_MAX_EVENTS    500000
+
+
+/**
+ * @brief The Tracer class. Records spans and writes them as Chrome / Perfetto trace event JSON.
+ */
+class Tracer
+{
+    public:
+
+        /**
+         * @brief The Event struct. A recorded span.
+         */
+        struct Event {
+            QString     name;
+            const char* category;
+            qint64      start;
+            qint64      duration;
+            int         thread;
+        };
+
+    public:
+
+        /**
+         * @brief isEnabled. Is the trace recording.
+         *
+         *  @return     State.
+         */
+        static bool isEnabled()
+        {
+            return m_enabled.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * @brief start. Start recording.
+         *
+         *  @param path     Path of the trace file.
+         */
+        static void start( const QString& path );
+
+        /**
+         * @brief stop. Stop recording and write the trace file.
+         */
+        static void stop();
+
+        /**
+         * @brief now. Get the trace time.
+         *
+         *  @return     Time since the start of the trace (us).
+         */
+        static qint64 now();
+
+        /**
+         * @brief complete. Record a span.
+         *
+         *  @param name         Name of the span.
+         *  @param category     Category of the span.
+         *  @param start        Start time (us).
+         *  @param duration     Duration (us).
+         */
+        static void complete( const QString& name, const char* category, qint64 start, qint64 duration );
+
+    private:
+
+        /**
+         * @brief threadId. Get the trace id of the current thread, register it on first use.
+         *
+         *  @return     The id.
+         */
+        static int threadId();
+
+        /**
+         * @brief m_enabled. Recording state.
+         */
+        static std::atomic< bool > m_enabled;
+
+        /**
+         * @brief m_path. Path of the trace file.
+         */
+        static QString m_path;
+
+        /**
+         * @brief m_clock. The trace clock.
+         */
+        static QElapsedTimer m_clock;
+
+        /**
+         * @brief m_mutex. Protects the recorded spans.
+         */
+        static QMutex m_mutex;
+
+        /**
+         * @brief m_events. The recorded spans.
+         */
+        static QVector< Event > m_events;
+
+        /**
+         * @brief m_threads. The names of the traced threads.
+         */
+        static QMap< int, QString > m_threads;
+
+        /**
+         * @brief m_dropped. Number of spans dropped.
+         */
+        static int m_dropped;
+};
+
+
+/**
+ * @brief The TraceSpan class. Records a span for its lifetime, only when tracing.
+ */
+class TraceSpan
+{
+    public:
+
+        /**
+         * @brief TraceSpan. Constructor, destructor.
+         *
+         *  @param name         Name of the span.
+         *  @param category     Category of the span.
+         */
+        TraceSpan( const char* name, const char* category );
+        ~TraceSpan();
+
+    private:
+
+        /**
+         * @brief m_name. Name of the span.
+         */
+        const char* m_name;
+
+        /**
+         * @brief m_category. Category of the span.
+         */
+        const char* m_category;
+
+        /**
+         * @brief m_start. Start time (us), -1 when not tracing.
+         */
+        qint64  m_start;
+};
+
+#endif // TRACER_H
@@ -7,22 +7,60 @@
  */
 #include "debug.h"
 #include "preferences.h"
+#include "logger.h"
+#include "tracer.h"
 
 /*
  *  System includes
  */
 #include <unistd.h>
+#include <algorithm>
 
 /*
  *  Qt includes
  */
 #include <QApplication>
-#include <QTime>
 #include <QTimer>
-#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
-#include <QElapsedTimer>
-#endif
 #include <QFileInfo>
+#include <QSocketNotifier>
+
+
+/*
+ *  Constants
+ */
+const QStringList   WindowCtrlUnix::WindowStates = {
+    "_NET_WM_STATE_MODAL",
+    "_NET_WM_STATE_STICKY",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_SHADED",
+    "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_STATE_SKIP_PAGER",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_WM_STATE_BELOW",
+    "_NET_WM_STATE_DEMANDS_ATTENTION"
+};
+
+const QStringList   WindowCtrlUnix::OperationTypes = {
+    "Find",
+    "Minimize",
+    "Normalize",
+    "Update positions",
+    "Delete"
+};
+
+const QStringList   WindowCtrlUnix::CachedProperties = {
+    "_NET_WM_PID",
+    "WM_WINDOW_ROLE",
+    "WM_STATE",
+    "_NET_WM_STATE",
+    "_NET_FRAME_EXTENTS",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_CLIENT_LIST",
+    "_NET_WM_NAME"
+};
 
 
 /*
@@ -34,21 +72,122 @@ WindowCtrlUnix::WindowCtrlUnix( QObject *parent ) : QObject( parent )
      *  Initialize
      */
     m_tb_windows = QList< quint64 >();
-    m_tb_window_refs = QMap< int, quint64 >();
-    m_tb_window_positions = QMap< quint64, QPoint >();
-    m_tb_window_states = QMap< quint64, Preferences::WindowState >();
-    m_tb_window_states_x11 = QMap< quint64, QStringList >();
-    m_tb_window_hints = QMap< quint64, SizeHints >();
+    m_tb_window_records = QHash< quint64, WindowRecord >();
+    m_window_states_atoms = QVector< long >( WindowStates.length(), 0 );
+    m_property_atoms = QVector< long >( CachedProperties.length(), 0 );
+    m_property_cache = QHash< QPair< quint64, long >, PropertyValue >();
+    m_event_masks = QHash< quint64, long >();
+    m_cache_hits = 0;
+    m_cache_misses = 0;
+    m_x11_notifier = nullptr;
+    m_clients_changed = true;
+    m_window_positions_correction = false;
+    m_window_positions_correction_type = Preferences::PREF_NO_CORRECTION;
+
+    /*
+     *  Setup the state confirmation poll
+     */
+    m_confirm_pending = QMap< quint64, ConfirmPending >();
+    m_confirm_timed_out = 0;
+    m_confirm_confirmed = 0;
+    m_confirm_failed = 0;
+
+    /*
+     *  Setup the operation statistics
+     */
+    m_open_operations = QList< OperationResult >();
+    m_unattributed_errors = 0;
+    m_operation_stats = QVector< OperationStats >( OperationTypes.length() );
+    m_stats_clock.start();
+
+    /*
+     *  Setup the position tracking
+     */
+    m_positions_timer = new QTimer( this );
+    m_positions_timer->setSingleShot( true );
+    m_positions_timer->setInterval( POSITIONS_DEBOUNCE_TIMEOUT );
+    connect( m_positions_timer, &QTimer::timeout, this, &WindowCtrlUnix::updatePositions );
+
+    /*
+     *  Setup the window identification
+     */
+    m_pending_identify = QMap< QString, int >();
+    m_identify_retry = false;
+
+    m_identify_timer = new QTimer( this );
+    m_identify_timer->setSingleShot( true );
+    m_identify_timer->setInterval( IDENTIFY_TIMEOUT );
+    connect( m_identify_timer, &QTimer::timeout, this, &WindowCtrlUnix::slotIdentifyTimeout );
+
+    m_confirm_timer = new QTimer( this );
+    m_confirm_timer->setInterval( STATES_CONFIRM_INTERVAL );
+    connect( m_confirm_timer, &QTimer::timeout, this, &WindowCtrlUnix::slotConfirmStates );
 
     /*
-     *  Set the X11 error handler
+     *  The display is opened by the thread owning it
      */
-    SetErrorHandler();
+    m_display = nullptr;
+    m_root_window = 0;
+}
 
+
+/*
+ *  Open the X11 connection
+ */
+void    WindowCtrlUnix::openDisplay()
+{
     /*
      *  Get the base display and window
      */
     m_display = OpenDisplay();
+
+    /*
+     *  Set the X11 error handler, record the errors of this display
+     */
+    SetErrorHandler( m_display );
+
+    m_root_window = GetDefaultRootWindow( m_display );
+
+    /*
+     *  Get the window state and property atoms in one go
+     */
+    m_window_states_atoms = internAtoms( WindowStates );
+    m_property_atoms = internAtoms( CachedProperties );
+
+    /*
+     *  Listen to the root window, the client list tells when windows are managed
+     */
+    selectEvents( m_root_window, _PROPERTY_CHANGE_MASK );
+
+    /*
+     *  Handle the X11 events in the event loop of this thread
+     */
+    m_x11_notifier = new QSocketNotifier( GetConnectionNumber( m_display ), QSocketNotifier::Read, this );
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    connect( m_x11_notifier, SIGNAL( activated( int ) ), this, SLOT( slotX11Events() ) );
+#else
+    connect( m_x11_notifier, &QSocketNotifier::activated, this, &WindowCtrlUnix::slotX11Events );
+#endif
+}
+
+
+/*
+ *  Get the atoms of a list of names
+ */
+QVector< long > WindowCtrlUnix::internAtoms( const QStringList& names )
+{
+    QList< QByteArray > names_latin1;
+    QVector< const char* > names_ptr;
+    for( int i = 0 ; i < names.length() ; ++i )
+    {
+        names_latin1.append( names.at( i ).toLatin1() );
+        names_ptr.append( names_latin1.last().constData() );
+    }
+
+    QVector< long > atoms( names.length(), 0 );
+    InternAtoms( m_display, names_ptr.data(), names_ptr.length(), atoms.data() );
+
+    return atoms;
 }
 
 
@@ -115,6 +254,24 @@ Preferences::CloseType    WindowCtrlUnix::getCloseType() const
 }
 
 
+/*
+ *  Set the window positions correction state
+ */
+void    WindowCtrlUnix::setWindowPositionsCorrection( bool state )
+{
+    m_window_positions_correction = state;
+}
+
+
+/*
+ *  Set the window positions correction type
+ */
+void    WindowCtrlUnix::setWindowPositionsCorrectionType( Preferences::WindowPositionsCorrectionType type )
+{
+    m_window_positions_correction_type = type;
+}
+
+
 /*
  *  Get the parent pid of SysTray-X, TB hopefully
  */
@@ -152,119 +309,132 @@ QString WindowCtrlUnix::getProcessName( qint64 pid ) const
 void    WindowCtrlUnix::findWindows( qint64 pid )
 {
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Find windows" );
+    LOG_DEBUG( "Find windows" );
 #endif
 
-    QList< WindowItem > windows = listXWindows( m_display, GetDefaultRootWindow( m_display ) );
+    OperationStart start = beginOperation();
 
-    QMap< quint64, QPoint > old_positions = m_tb_window_positions;
+    /*
+     *  Drop the outdated cached properties
+     */
+    processX11Events();
 
-    m_tb_windows = QList< quint64 >();
-    m_tb_window_positions = QMap< quint64, QPoint >();
+    /*
+     *  A window may have been seen before it got its pid and role
+     */
+    if( m_clients_changed )
+    {
+        refreshStaticProperties();
+    }
+
+    QList< WindowItem > windows = listXWindows( m_display, m_root_window );
+
+    QHash< quint64, WindowRecord > old_records = m_tb_window_records;
+
+    clearWindows();
     for( int i = 0 ; i < windows.length() ; ++i )
     {
         WindowItem win = windows.at( i );
 
-        qint32 n_propPID;
-        void* propPID = GetWindowProperty( m_display, win.window, "_NET_WM_PID", &n_propPID );
-
-        if( propPID != nullptr )
+        if( is3PaneWindow( win.window, pid ) )
         {
-            if( pid == *((reinterpret_cast<qint64 *>( propPID ) ) ) )
+            /*
+             *  Keep the record of a known window
+             */
+            QHash< quint64, WindowRecord >::const_iterator old_record = old_records.constFind( win.window );
+            if( old_record == old_records.constEnd() )
+            {
+                LOG_DEBUG( "Position not found" );
+            }
+
+            WindowRecord& record = addWindow( win.window,
+                    old_record != old_records.constEnd() ? old_record.value() : WindowRecord() );
+
+            /*
+             *  Track the geometry changes
+             */
+            selectEvents( win.window, _STRUCTURE_NOTIFY_MASK );
+
+            PropertyValue prop_wm_state = getProperty( win.window, PROPERTY_WM_STATE );
+
+            Preferences::WindowState win_state = Preferences::STATE_DOCKED;
+            bool add_new_state = true;
+            if( prop_wm_state.valid && prop_wm_state.length > 0 )
             {
-                qint32 n_str;
-                void* str_ptr = GetWindowProperty( m_display, win.window, "WM_WINDOW_ROLE", &n_str );
+                int state = *reinterpret_cast< const long* >( prop_wm_state.data.constData() );
 
-                if( str_ptr != nullptr )
+                switch( state )
                 {
-                    if( strcmp( (char*)str_ptr, "3pane") == 0 )
+                    case 0:
+                    {
+                        /*
+                         *  Docked
+                         */
+                        win_state = Preferences::STATE_DOCKED;
+
+                        break;
+                    }
+
+                    case 1:
+                    {
+                        /*
+                         *  Normal
+                         */
+                        win_state = Preferences::STATE_NORMAL;
+
+                        break;
+                    }
+
+                    case 3:
                     {
-                        m_tb_windows.append( win.window );
-
-                        QPoint point;
-                        if( old_positions.contains( win.window ) )
-                        {
-                            point = old_positions[ win.window ];
-                        }
-                        else
-                        {
-                            emit signalConsole( "Position not found" );
-                        }
-
-                        m_tb_window_positions[ win.window ] = point;
-
-                        qint32 n_wm_state;
-                        void* wm_state_ptr = GetWindowProperty( m_display, win.window, "WM_STATE", &n_wm_state );
-
-                        Preferences::WindowState win_state = Preferences::STATE_DOCKED;
-                        bool add_new_state = true;
-                        if( wm_state_ptr != nullptr )
-                        {
-                            int state = *reinterpret_cast<long *>( wm_state_ptr );
-
-                            switch( state )
-                            {
-                                case 0:
-                                {
-                                    /*
-                                     *  Docked
-                                     */
-                                    win_state = Preferences::STATE_DOCKED;
-
-                                    break;
-                                }
-
-                                case 1:
-                                {
-                                    /*
-                                     *  Normal
-                                     */
-                                    win_state = Preferences::STATE_NORMAL;
-
-                                    break;
-                                }
-
-                                case 3:
-                                {
-                                    /*
-                                     *  Minimized
-                                     */
-                                    win_state = Preferences::STATE_MINIMIZED;
-
-                                    break;
-                                }
-
-                                default:
-                                {
-                                    add_new_state = false;
-
-                                    break;
-                                }
-                            }
-
-                            Free( wm_state_ptr );
-                        }
-
-                        if( add_new_state )
-                        {
-                            m_tb_window_states[ win.window ] = win_state;
-                        }
+                        /*
+                         *  Minimized
+                         */
+                        win_state = Preferences::STATE_MINIMIZED;
+
+                        break;
                     }
 
-                    Free( str_ptr );
+                    default:
+                    {
+                        add_new_state = false;
+
+                        break;
+                    }
                 }
             }
 
-            Free( propPID );
+            if( add_new_state )
+            {
+                record.state = win_state;
+
+                if( record.requested == win_state )
+                {
+                    record.requested = Preferences::STATE_UNKNOWN;
+                }
+            }
         }
     }
 
+    /*
+     *  Forget the windows that are gone
+     */
+    QSet< quint64 > existing;
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        existing.insert( windows.at( i ).window );
+    }
+    existing.insert( m_root_window );
+    forgetWindows( existing );
+
+    endOperation( OPERATION_FIND, start );
+
 #ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
-    emit signalConsole( QString( "Number of windows found: %1" ).arg( m_tb_windows.length() ) );
+    LOG_DEBUG( QString( "Number of windows found: %1" ).arg( m_tb_windows.length() ) );
 #endif
 
 #ifdef DEBUG_DISPLAY_ACTIONS_END
-    emit signalConsole( "Find windows done" );
+    LOG_DEBUG( "Find windows done" );
 #endif
 }
 
@@ -280,21 +450,14 @@ void    WindowCtrlUnix::identifyWindow( int id )
     findWindows( getPpid() );
 
     /*
-     *  Get the list
-     */
-    QList<quint64>  win_list = m_tb_windows;
-
-    /*
-     *  Remove known ids
+     *  Get the windows without a TB id
      */
-    QMapIterator<int, quint64> it(m_tb_window_refs);
-    while (it.hasNext()) {
-        it.next();
-
-        int found = win_list.indexOf( it.value() );
-        if( found != -1 )
+    QList< quint64 > win_list;
+    for( int i = 0 ; i < m_tb_windows.length() ; ++i )
+    {
+        if( m_tb_window_records.value( m_tb_windows.at( i ) ).ref_id == -1 )
         {
-            win_list.removeAt( found );
+            win_list.append( m_tb_windows.at( i ) );
         }
     }
 
@@ -303,404 +466,1362 @@ void    WindowCtrlUnix::identifyWindow( int id )
      */
     if( win_list.length() > 0 )
     {
-        m_tb_window_refs[ id ] = win_list[ 0 ];
+        bindWindow( id, win_list.at( 0 ) );
     }
 
     if( win_list.length() != 1 )
     {
-//        emit signalConsole( QString( "Unexpected Ids: %1" ).arg( win_list.length() ) );
+//        LOG_DEBUG( QString( "Unexpected Ids: %1" ).arg( win_list.length() ) );
     }
 }
 
 
 /*
- *  Get the Thunderbird window IDs
- */
-const QList< quint64 >&   WindowCtrlUnix::getWinIds() const
-{
-    return m_tb_windows;
-}
-
-
-/*
- *  Get the reference IDs
+ *  Match the TB window id by the token in its title
  */
-const QMap< int, quint64 >&   WindowCtrlUnix::getRefIds() const
+void    WindowCtrlUnix::identifyWindow( int id, const QString& token )
 {
-    return m_tb_window_refs;
-}
+    m_pending_identify.insert( token, id );
 
+    matchPendingWindows();
 
-/*
- *  Get the reference IDs
- */
-void    WindowCtrlUnix::removeRefId( int id )
-{
-    m_tb_window_refs.remove( id );
+    if( !m_pending_identify.isEmpty() )
+    {
+        /*
+         *  Title not there yet, retry on title changes, fallback after a while
+         */
+        m_identify_timer->start();
+    }
 }
 
 
 /*
- *  Get the states of the TB windows.
+ *  Match the pending tokens against the client window titles
  */
-const Preferences::WindowState&    WindowCtrlUnix::getWindowState( const quint64 window )
+void    WindowCtrlUnix::matchPendingWindows()
 {
-    return m_tb_window_states[ window ];
-}
+    processX11Events();
+    m_identify_retry = false;
 
+    /*
+     *  The managed windows, cached until the window manager changes the list
+     */
+    PropertyValue prop_clients = getProperty( m_root_window, PROPERTY_NET_CLIENT_LIST );
+    if( !prop_clients.valid )
+    {
+        /*
+         *  Not an EWMH window manager
+         */
+        slotIdentifyTimeout();
+        return;
+    }
 
-/*
- *  Get window positions
- */
-void    WindowCtrlUnix::updatePositions()
-{
-#ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Update positions" );
-#endif
 
-    bool changed = false;
-    for( int i = 0 ; i < m_tb_windows.length() ; ++i )
+    const long* clients = reinterpret_cast< const long* >( prop_clients.data.constData() );
+    for( qint32 i = 0 ; i < prop_clients.length && !m_pending_identify.isEmpty() ; ++i )
     {
-        quint64 window = m_tb_windows.at( i );
+        quint64 client = (quint64)clients[ i ];
 
-        QStringList x11_state = getWindowStateX11( window );
-        if( x11_state.contains( "_NET_WM_STATE_MAXIMIZED_VERT" ) &&
-                x11_state.contains( "_NET_WM_STATE_MAXIMIZED_HORZ" ) )
+        QHash< quint64, WindowRecord >::const_iterator record = m_tb_window_records.constFind( client );
+        if( record != m_tb_window_records.constEnd() && record.value().ref_id != -1 )
         {
-            /*
-             *  Maximized, skip position store
-             */
             continue;
         }
 
-        if( m_tb_window_states[ window ] != Preferences::STATE_MINIMIZED && m_tb_window_states[ window ] != Preferences::STATE_DOCKED )
+        /*
+         *  Only the Thunderbird main windows carry a token, the other titles are not watched
+         */
+        if( !is3PaneWindow( client, getPpid() ) )
         {
-            /*
-             *  Get border / title bar sizes
-             */
-            int left;
-            int top;
-            int right;
-            int bottom;
-            GetWindowFrameExtensions( m_display, window, &left, &top, &right, &bottom );
+            continue;
+        }
 
-#ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
-            emit signalConsole( QString( "Margins: %1, %2, %3, %4" ).arg( left ).arg( top ).arg( right ).arg( bottom ) );
-#endif
+        /*
+         *  Only new windows and changed titles cause a request
+         */
+        PropertyValue prop_name = getProperty( client, PROPERTY_NET_WM_NAME );
+        if( !prop_name.valid )
+        {
+            continue;
+        }
 
-            /*
-             *  Get the position
-             */
-            int x;
-            int y;
-            GetWindowPosition( m_display, window, &x, &y );
+        QString title = QString::fromUtf8( prop_name.data );
 
-            /*
-             *  Apply the requested correction
-             */
-            QPoint point;
-            switch( m_pref->getWindowPositionsCorrectionType() )
+        QMap< QString, int >::iterator it = m_pending_identify.begin();
+        while( it != m_pending_identify.end() )
+        {
+            if( title.contains( it.key() ) )
             {
-                case Preferences::PREF_NO_CORRECTION:
-                {
-                    point = QPoint( x, y );
-                    break;
-                }
+                bindWindow( it.value(), client );
 
-                case Preferences::PREF_ADD_CORRECTION:
-                {
-                    point = QPoint( x + left, y + top );
-                    break;
-                }
+                emit signalWindowIdentified( it.value() );
 
-                case Preferences::PREF_SUBTRACT_CORRECTION:
-                {
-                    point = QPoint( x - left, y - top );
-                    break;
-                }
+                it = m_pending_identify.erase( it );
             }
-
-            /*
-             *  Update the list?
-             */
-            if( m_tb_window_positions[ window ] != point )
+            else
             {
-                m_tb_window_positions[ window ] = point;
-
-                /*
-                 *  Mar the list changed
-                 */
-                changed = true;
+                ++it;
             }
-
-#ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
-            emit signalConsole( QString( "Update pos: %1, %2" ).arg( x ).arg( y ) );
-            emit signalConsole( QString( "Update pos corrected: %1, %2" ).arg( point.x() ).arg( point.y() ) );
-#endif
         }
     }
 
-    if( changed )
+    if( m_pending_identify.isEmpty() )
     {
-        emit signalPositions( m_tb_window_positions.values() );
+        m_identify_timer->stop();
     }
-
-#ifdef DEBUG_DISPLAY_ACTIONS_END
-    emit signalConsole( "Update positions done" );
-#endif
 }
 
 
 /*
- *  Minimize a window to the taskbar
+ *  Connect a TB window id to a X11 window
  */
-void    WindowCtrlUnix::minimizeWindowToTaskbar( quint64 window )
+void    WindowCtrlUnix::bindWindow( int id, quint64 window )
 {
-#ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Minimize to taskbar" );
-#endif
-
-    /*
-     *  Store the current window positions
-     */
-    updatePositions();
-
     /*
-     *  Save the hints
+     *  A TB id refers to one window only
      */
-    GetWMNormalHints( m_display, window, &m_tb_window_hints[ window ] );
-
-    /*
-     *  Get and store the X11 window state
-     */
-    m_tb_window_states_x11[ window ] = getWindowStateX11( window );
+    QHash< quint64, WindowRecord >::iterator it = m_tb_window_records.begin();
+    for( ; it != m_tb_window_records.end() ; ++it )
+    {
+        if( it.value().ref_id == id )
+        {
+            it.value().ref_id = -1;
+        }
+    }
 
-    /*
-     *  Minimize the window
-     */
-    IconifyWindow( m_display, window );
+    it = m_tb_window_records.find( window );
+    if( it == m_tb_window_records.end() )
+    {
+        /*
+         *  New Thunderbird window
+         */
+        WindowRecord record;
+        record.state = Preferences::STATE_NORMAL;
+        record.ref_id = id;
 
-    /*
-     *  Sync the events
-     */
-    Sync( m_display );
+        addWindow( window, record );
 
-    /*
-     *  Store the window state
-     */
-    m_tb_window_states[ window ] = Preferences::STATE_MINIMIZED;
+        selectEvents( window, _STRUCTURE_NOTIFY_MASK );
 
-    /*
-     *  Flush the pipes
-     */
-    Sync( m_display );
+        return;
+    }
 
-#ifdef DEBUG_DISPLAY_ACTIONS_END
-    emit signalConsole( "Minimize to taskbar done" );
-#endif
+    it.value().ref_id = id;
 }
 
 
 /*
- *  Minimize window to the tray
+ *  Add a Thunderbird window, keeps the order and the records in step
  */
-void    WindowCtrlUnix::minimizeWindowToTray( quint64 window )
+WindowCtrlUnix::WindowRecord&   WindowCtrlUnix::addWindow( quint64 window, const WindowRecord& record )
 {
-#ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Minimize to system tray" );
-#endif
+    m_tb_windows.append( window );
 
-    /*
-     *  Store the current window positions
-     */
-    updatePositions();
+    return m_tb_window_records.insert( window, record ).value();
+}
 
-    /*
-     *  Save the hints
-     */
-    GetWMNormalHints( m_display, window, &m_tb_window_hints[ window ] );
 
-    /*
-     *  Get and store the X11 window state
-     */
-    m_tb_window_states_x11[ window ] = getWindowStateX11( window );;
+/*
+ *  Forget all Thunderbird windows
+ */
+void    WindowCtrlUnix::clearWindows()
+{
+    m_tb_windows.clear();
+    m_tb_window_records.clear();
+}
 
-    /*
-     *  Set the flags (GNOME, Wayland?)
-     */
-    SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_SKIP_TASKBAR );
-    SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_SKIP_PAGER );
 
+/*
+ *  Identify the unmatched windows by elimination
+ */
+void    WindowCtrlUnix::slotIdentifyTimeout()
+{
+    QList< int > ids = m_pending_identify.values();
+    m_pending_identify.clear();
+
+    for( int i = 0 ; i < ids.length() ; ++i )
+    {
+        identifyWindow( ids.at( i ) );
+
+        /*
+         *  Let the add-on remove the token
+         */
+        emit signalWindowIdentified( ids.at( i ) );
+    }
+}
+
+
+/*
+ *  Get the Thunderbird window IDs
+ */
+const QList< quint64 >&   WindowCtrlUnix::getWinIds() const
+{
+    return m_tb_windows;
+}
+
+
+/*
+ *  Get the reference IDs
+ */
+QMap< int, quint64 >    WindowCtrlUnix::getRefIds() const
+{
+    QMap< int, quint64 > refs;
+
+    QHash< quint64, WindowRecord >::const_iterator it = m_tb_window_records.constBegin();
+    for( ; it != m_tb_window_records.constEnd() ; ++it )
+    {
+        if( it.value().ref_id != -1 )
+        {
+            refs.insert( it.value().ref_id, it.key() );
+        }
+    }
+
+    return refs;
+}
+
+
+/*
+ *  Get the reference IDs
+ */
+void    WindowCtrlUnix::removeRefId( int id )
+{
+    QHash< quint64, WindowRecord >::iterator it = m_tb_window_records.begin();
+    for( ; it != m_tb_window_records.end() ; ++it )
+    {
+        if( it.value().ref_id == id )
+        {
+            it.value().ref_id = -1;
+        }
+    }
+}
+
+
+/*
+ *  Get the states of the TB windows.
+ */
+Preferences::WindowState    WindowCtrlUnix::getWindowState( const quint64 window ) const
+{
+    QHash< quint64, WindowRecord >::const_iterator it = m_tb_window_records.constFind( window );
+    if( it == m_tb_window_records.constEnd() )
+    {
+        return Preferences::STATE_UNKNOWN;
+    }
+
+    /*
+     *  The last request wins until the window manager confirms or rejects it
+     */
+    if( it.value().requested != Preferences::STATE_UNKNOWN )
+    {
+        return it.value().requested;
+    }
+
+    return it.value().state;
+}
+
+
+/*
+ *  Is a state request waiting for the window manager
+ */
+bool    WindowCtrlUnix::isStatePending( const quint64 window ) const
+{
+    QHash< quint64, WindowRecord >::const_iterator it = m_tb_window_records.constFind( window );
+
+    return it != m_tb_window_records.constEnd() && it.value().requested != Preferences::STATE_UNKNOWN;
+}
+
+
+/*
+ *  Update the state of a known TB window
+ */
+void    WindowCtrlUnix::refreshWindowState( const quint64 window )
+{
+    /*
+     *  Handle the queued property changes first, the cached WM_STATE may be stale
+     */
+    processX11Events();
+
+    updateConfirmedState( window );
+}
+
+
+/*
+ *  Get window positions
+ */
+void    WindowCtrlUnix::updatePositions()
+{
+#ifdef DEBUG_DISPLAY_ACTIONS
+    LOG_DEBUG( "Update positions" );
+#endif
+
+    OperationStart start = beginOperation();
+
+    /*
+     *  Drop the outdated cached properties
+     */
+    processX11Events();
+
+    bool changed = false;
+    for( int i = 0 ; i < m_tb_windows.length() ; ++i )
+    {
+        quint64 window = m_tb_windows.at( i );
+
+        QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( window );
+        if( record == m_tb_window_records.end() )
+        {
+            continue;
+        }
+
+        if( isMaximizedX11( getWindowStateX11( window ) ) )
+        {
+            /*
+             *  Maximized, skip position store
+             */
+            continue;
+        }
+
+        if( record.value().state != Preferences::STATE_MINIMIZED && record.value().state != Preferences::STATE_DOCKED )
+        {
+            /*
+             *  Get border / title bar sizes
+             */
+            int left = 0;
+            int top = 0;
+            int right = 0;
+            int bottom = 0;
+
+            PropertyValue prop_extents = getProperty( window, PROPERTY_NET_FRAME_EXTENTS );
+            if( prop_extents.valid && prop_extents.length == 4 )
+            {
+                const long* extents = reinterpret_cast< const long* >( prop_extents.data.constData() );
+                left = (int)extents[ 0 ];
+                right = (int)extents[ 1 ];
+                top = (int)extents[ 2 ];
+                bottom = (int)extents[ 3 ];
+            }
+
+#ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
+            LOG_DEBUG( QString( "Margins: %1, %2, %3, %4" ).arg( left ).arg( top ).arg( right ).arg( bottom ) );
+#endif
+
+            /*
+             *  Get the position
+             */
+            QPoint position = getWindowPositionTracked( window );
+            int x = position.x();
+            int y = position.y();
+
+            /*
+             *  Apply the requested correction
+             */
+            QPoint point;
+            switch( m_window_positions_correction_type )
+            {
+                case Preferences::PREF_NO_CORRECTION:
+                {
+                    point = QPoint( x, y );
+                    break;
+                }
+
+                case Preferences::PREF_ADD_CORRECTION:
+                {
+                    point = QPoint( x + left, y + top );
+                    break;
+                }
+
+                case Preferences::PREF_SUBTRACT_CORRECTION:
+                {
+                    point = QPoint( x - left, y - top );
+                    break;
+                }
+            }
+
+            /*
+             *  Update the list?
+             */
+            if( record.value().position != point )
+            {
+                record.value().position = point;
+
+                /*
+                 *  Mar the list changed
+                 */
+                changed = true;
+            }
+
+#ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
+            LOG_DEBUG( QString( "Update pos: %1, %2" ).arg( x ).arg( y ) );
+            LOG_DEBUG( QString( "Update pos corrected: %1, %2" ).arg( point.x() ).arg( point.y() ) );
+#endif
+        }
+    }
+
+    endOperation( OPERATION_UPDATE_POSITIONS, start );
+
+    if( changed )
+    {
+        /*
+         *  Report the positions ordered by window id
+         */
+        QList< quint64 > windows = m_tb_windows;
+        std::sort( windows.begin(), windows.end() );
+
+        QList< QPoint > positions;
+        for( int i = 0 ; i < windows.length() ; ++i )
+        {
+            positions.append( m_tb_window_records.value( windows.at( i ) ).position );
+        }
+
+        emit signalPositions( positions );
+    }
+
+#ifdef DEBUG_DISPLAY_ACTIONS_END
+    LOG_DEBUG( "Update positions done" );
+#endif
+}
+
+
+/*
+ *  Minimize a window to the taskbar
+ */
+void    WindowCtrlUnix::minimizeWindowToTaskbar( quint64 window )
+{
+    minimizeWindowsToTaskbar( QList< quint64 >() << window );
+}
+
+
+/*
+ *  Minimize window to the tray
+ */
+void    WindowCtrlUnix::minimizeWindowToTray( quint64 window )
+{
+    minimizeWindowsToTray( QList< quint64 >() << window );
+}
+
+
+/*
+ *  Normalize a window
+ */
+void    WindowCtrlUnix::normalizeWindow( quint64 window )
+{
+    normalizeWindows( QList< quint64 >() << window );
+}
+
+
+/*
+ *  Minimize windows to the taskbar
+ */
+void    WindowCtrlUnix::minimizeWindowsToTaskbar( const QList< quint64 >& requested )
+{
+    /*
+     *  Drop the duplicate requests
+     */
+    QList< quint64 > windows = requestStates( requested, Preferences::STATE_MINIMIZED );
+
+#ifdef DEBUG_DISPLAY_ACTIONS
+    LOG_DEBUG( QString( "Minimize to taskbar: %1 window(s), %2 dropped" )
+               .arg( windows.length() ).arg( requested.length() - windows.length() ) );
+#endif
+
+    if( windows.isEmpty() )
+    {
+        return;
+    }
+
+    OperationStart start = beginOperation();
+
+    /*
+     *  Store the current window states
+     */
+    storeWindowStates( windows );
+
+    /*
+     *  Minimize the windows
+     */
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        IconifyWindow( m_display, windows.at( i ) );
+    }
+
+    /*
+     *  Flush the pipes, errors are attributed when they arrive
+     */
+    Flush( m_display );
+
+    /*
+     *  Wait for the window manager to follow
+     */
+    startConfirm( windows, WM_STATE_ICONIC );
+
+    endOperation( OPERATION_MINIMIZE, start );
+
+#ifdef DEBUG_DISPLAY_ACTIONS_END
+    LOG_DEBUG( "Minimize to taskbar done" );
+#endif
+}
+
+
+/*
+ *  Minimize windows to the tray
+ */
+void    WindowCtrlUnix::minimizeWindowsToTray( const QList< quint64 >& requested )
+{
+    /*
+     *  Drop the duplicate requests
+     */
+    QList< quint64 > windows = requestStates( requested, Preferences::STATE_DOCKED );
+
+#ifdef DEBUG_DISPLAY_ACTIONS
+    LOG_DEBUG( QString( "Minimize to system tray: %1 window(s), %2 dropped" )
+               .arg( windows.length() ).arg( requested.length() - windows.length() ) );
+#endif
+
+    if( windows.isEmpty() )
+    {
+        return;
+    }
+
+    OperationStart start = beginOperation();
+
+    /*
+     *  Store the current window states
+     */
+    storeWindowStates( windows );
+
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        quint64 window = windows.at( i );
+
+        /*
+         *  Set the flags (GNOME, Wayland?)
+         */
+        SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_SKIP_TASKBAR );
+        SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_SKIP_PAGER );
+
+        /*
+         *  Remove from taskbar and task switchers
+         */
+        WithdrawWindow( m_display, window );
+    }
+
+    /*
+     *  Flush the pipes, errors are attributed when they arrive
+     */
+    Flush( m_display );
+
+    /*
+     *  Wait for the window manager to follow
+     */
+    startConfirm( windows, WM_STATE_WITHDRAWN );
+
+    endOperation( OPERATION_MINIMIZE, start );
+
+#ifdef DEBUG_DISPLAY_ACTIONS_END
+    LOG_DEBUG( "Minimize to system tray done" );
+#endif
+}
+
+
+/*
+ *  Normalize windows
+ */
+void    WindowCtrlUnix::normalizeWindows( const QList< quint64 >& requested )
+{
+    /*
+     *  Drop the outdated cached properties
+     */
+    processX11Events();
+
+    /*
+     *  Drop the duplicate requests
+     */
+    QList< quint64 > windows = requestStates( requested, Preferences::STATE_NORMAL );
+
+#if defined DEBUG_DISPLAY_ACTIONS
+    LOG_DEBUG( QString( "Normalize: %1 window(s), %2 dropped" )
+               .arg( windows.length() ).arg( requested.length() - windows.length() ) );
+#endif
+
+    if( windows.isEmpty() )
+    {
+        return;
+    }
+
+    OperationStart start = beginOperation();
+
+    /*
+     *  Get the current desktop
+     */
+    PropertyValue prop_desktop = getProperty( m_root_window, PROPERTY_NET_CURRENT_DESKTOP );
+    bool current_desktop_valid = prop_desktop.valid && prop_desktop.length > 0;
+    long current_desktop = current_desktop_valid ? *reinterpret_cast< const long* >( prop_desktop.data.constData() ) : 0;
+
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        quint64 window = windows.at( i );
+
+        /*
+         *  Unknown windows are normalized without bookkeeping
+         */
+        WindowRecord unknown;
+        QHash< quint64, WindowRecord >::iterator it = m_tb_window_records.find( window );
+        WindowRecord& record = it != m_tb_window_records.end() ? it.value() : unknown;
+
+        /*
+         *  Show window on taskbar and in the switcher, also when the withdraw is still on its way
+         */
+        if( record.state == Preferences::STATE_DOCKED || record.previous == Preferences::STATE_DOCKED )
+        {
+            MapWindow( m_display, window );
+
+            /*
+             *  Reset the hide flags
+             */
+            SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_REMOVE, _ATOM_SKIP_TASKBAR );
+            SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_REMOVE, _ATOM_SKIP_PAGER );
+
+            /*
+             *  Was the window maximized?
+             */
+            if( isMaximizedX11( record.states_x11 ) )
+            {
+                SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_MAXIMIZED );
+            }
+
+            /*
+             * Delete the X11 state
+             */
+            record.states_x11 = 0;
+
+            /*
+             *  Restore the size hints
+             */
+            SetWMNormalHints( m_display, window, record.hints );
+        }
+
+        /*
+         *  Raise the window to the top
+         */
+        MapRaised( m_display, window );
+
+        /*
+         *  Set the desktop for the window
+         */
+        if( current_desktop_valid )
+        {
+            SendEvent( m_display, window, "_NET_WM_DESKTOP", current_desktop, 1 );
+        }
+
+        /*
+         *  Normalize
+         */
+        SendEvent( m_display, window, "_NET_ACTIVE_WINDOW" );
+    }
+
+    /*
+     *  Flush the pipes, errors are attributed when they arrive
+     */
     Flush( m_display );
 
-    /*
-     *  Remove from taskbar and task switchers
-     */
-    WithdrawWindow( m_display, window );
+    /*
+     *  Force the windows to the last known position?
+     */
+    if( m_window_positions_correction )
+    {
+        /*
+         *  Move the windows to the last recorded position
+         */
+        for( int i = 0 ; i < windows.length() ; ++i )
+        {
+            QPoint pos = m_tb_window_records.value( windows.at( i ) ).position;
+            MoveWindow( m_display, windows.at( i ), pos.x(), pos.y() );
+        }
+
+        Flush( m_display );
+    }
+
+    /*
+     *  Wait for the window manager to follow
+     */
+    startConfirm( windows, WM_STATE_NORMAL );
+
+    endOperation( OPERATION_NORMALIZE, start );
+
+#ifdef DEBUG_DISPLAY_ACTIONS_END
+    LOG_DEBUG( "Normalize done" );
+#endif
+}
+
+
+/*
+ *  Are there window states waiting for confirmation
+ */
+bool    WindowCtrlUnix::isConfirmPending() const
+{
+    return !m_confirm_pending.isEmpty();
+}
+
+
+/*
+ *  Store the window states before hiding
+ */
+void    WindowCtrlUnix::storeWindowStates( const QList< quint64 >& windows )
+{
+    /*
+     *  Store the current window positions
+     */
+    updatePositions();
+
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( windows.at( i ) );
+        if( record == m_tb_window_records.end() )
+        {
+            continue;
+        }
+
+        /*
+         *  Save the hints
+         */
+        GetWMNormalHints( m_display, record.key(), &record.value().hints );
+
+        /*
+         *  Get and store the X11 window state
+         */
+        record.value().states_x11 = getWindowStateX11( record.key() );
+    }
+}
+
+
+/*
+ *  Start waiting for the windows to reach the WM_STATE
+ */
+void    WindowCtrlUnix::startConfirm( const QList< quint64 >& windows, long wm_state )
+{
+    /*
+     *  Each window gets its own deadline, a new request does not extend the older ones
+     */
+    ConfirmPending pending;
+    pending.wm_state = wm_state;
+    pending.deadline = m_stats_clock.elapsed() + STATES_CONFIRM_TIMEOUT;
+
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        m_confirm_pending[ windows.at( i ) ] = pending;
+    }
+
+    if( !m_confirm_pending.isEmpty() && !m_confirm_timer->isActive() )
+    {
+        m_confirm_timer->start();
+    }
+}
+
+
+/*
+ *  Check the pending window states
+ */
+void    WindowCtrlUnix::slotConfirmStates()
+{
+    /*
+     *  Drop the outdated cached properties
+     */
+    processX11Events();
+
+    qint64 now = m_stats_clock.elapsed();
+
+    QMap< quint64, ConfirmPending >::iterator it = m_confirm_pending.begin();
+    while( it != m_confirm_pending.end() )
+    {
+        if( getWmStateX11( it.key() ) == it.value().wm_state )
+        {
+            updateConfirmedState( it.key() );
+
+            ++m_confirm_confirmed;
+            it = m_confirm_pending.erase( it );
+        }
+        else
+        if( now >= it.value().deadline )
+        {
+            /*
+             *  Give up on the timed out request, keep what the window manager reports
+             */
+            updateConfirmedState( it.key() );
+
+            QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( it.key() );
+            if( record != m_tb_window_records.end() )
+            {
+                record.value().requested = Preferences::STATE_UNKNOWN;
+            }
+
+            ++m_confirm_timed_out;
+            it = m_confirm_pending.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if( m_confirm_pending.isEmpty() )
+    {
+        m_confirm_timer->stop();
+
+        int confirmed = m_confirm_confirmed;
+        int timed_out = m_confirm_timed_out + m_confirm_failed;
+
+        m_confirm_confirmed = 0;
+        m_confirm_timed_out = 0;
+        m_confirm_failed = 0;
+
+#ifdef DEBUG_DISPLAY_ACTIONS_END
+        LOG_DEBUG( QString( "States confirmed: %1, timed out: %2" ).arg( confirmed ).arg( timed_out ) );
+#endif
+
+        emit signalWindowsConfirmed( confirmed, timed_out );
+    }
+}
+
+
+/*
+ *  Drop the duplicate requests and store the requested state
+ */
+QList< quint64 >    WindowCtrlUnix::requestStates( const QList< quint64 >& windows, Preferences::WindowState state )
+{
+    QList< quint64 > accepted;
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        QHash< quint64, WindowRecord >::iterator it = m_tb_window_records.find( windows.at( i ) );
+        if( it != m_tb_window_records.end() )
+        {
+            WindowRecord& record = it.value();
+
+            /*
+             *  Already on its way
+             */
+            if( record.requested == state )
+            {
+                continue;
+            }
+
+            /*
+             *  Already hidden, normalize always raises and activates
+             */
+            if( record.requested == Preferences::STATE_UNKNOWN && record.state == state &&
+                    state != Preferences::STATE_NORMAL )
+            {
+                continue;
+            }
+
+            /*
+             *  Supersede a pending request
+             */
+            record.previous = record.requested != Preferences::STATE_UNKNOWN ? record.requested : record.state;
+            record.requested = state;
+        }
+
+        accepted.append( windows.at( i ) );
+    }
+
+    return accepted;
+}
+
+
+/*
+ *  Update the confirmed state from the WM_STATE
+ */
+void    WindowCtrlUnix::updateConfirmedState( quint64 window )
+{
+    QHash< quint64, WindowRecord >::iterator it = m_tb_window_records.find( window );
+    if( it == m_tb_window_records.end() )
+    {
+        return;
+    }
+
+    WindowRecord& record = it.value();
+
+    switch( getWmStateX11( window ) )
+    {
+        case WM_STATE_NORMAL:
+        {
+            record.state = Preferences::STATE_NORMAL;
+            break;
+        }
+
+        case WM_STATE_ICONIC:
+        {
+            record.state = Preferences::STATE_MINIMIZED;
+            break;
+        }
+
+        default:
+        {
+            record.state = Preferences::STATE_DOCKED;
+            break;
+        }
+    }
+
+    if( record.requested == record.state )
+    {
+        record.requested = Preferences::STATE_UNKNOWN;
+    }
+}
+
+
+/*
+ *  Get the WM_STATE of a window
+ */
+long    WindowCtrlUnix::getWmStateX11( quint64 window )
+{
+    PropertyValue prop_wm_state = getProperty( window, PROPERTY_WM_STATE );
+
+    /*
+     *  No property means withdrawn
+     */
+    long state = WM_STATE_WITHDRAWN;
+    if( prop_wm_state.valid && prop_wm_state.length > 0 )
+    {
+        state = *reinterpret_cast< const long* >( prop_wm_state.data.constData() );
+    }
+
+    return state;
+}
+
+
+/*
+ *  Is the property set once when the window is created
+ */
+bool    WindowCtrlUnix::isStaticProperty( long atom ) const
+{
+    return atom == m_property_atoms.at( PROPERTY_NET_WM_PID ) ||
+            atom == m_property_atoms.at( PROPERTY_WM_WINDOW_ROLE );
+}
+
+
+/*
+ *  Forget the missing pid and role of the managed windows
+ */
+void    WindowCtrlUnix::refreshStaticProperties()
+{
+    PropertyValue prop_clients = getProperty( m_root_window, PROPERTY_NET_CLIENT_LIST );
+
+    /*
+     *  Without the client list every missing pid and role is read again
+     */
+    m_clients_changed = !prop_clients.valid;
+
+    QSet< quint64 > clients;
+    const long* client_list = reinterpret_cast< const long* >( prop_clients.data.constData() );
+    for( qint32 i = 0 ; prop_clients.valid && i < prop_clients.length ; ++i )
+    {
+        clients.insert( (quint64)client_list[ i ] );
+    }
+
+    QHash< QPair< quint64, long >, PropertyValue >::iterator it = m_property_cache.begin();
+    while( it != m_property_cache.end() )
+    {
+        if( !it.value().valid && isStaticProperty( it.key().second ) &&
+                ( !prop_clients.valid || clients.contains( it.key().first ) ) )
+        {
+            it = m_property_cache.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+/*
+ *  Is the window a Thunderbird main window
+ */
+bool    WindowCtrlUnix::is3PaneWindow( quint64 window, qint64 pid )
+{
+    PropertyValue prop_pid = getProperty( window, PROPERTY_NET_WM_PID );
+    if( !prop_pid.valid || prop_pid.length <= 0 ||
+            pid != *reinterpret_cast< const long* >( prop_pid.data.constData() ) )
+    {
+        return false;
+    }
+
+    PropertyValue prop_role = getProperty( window, PROPERTY_WM_WINDOW_ROLE );
+
+    return prop_role.valid && strcmp( prop_role.data.constData(), "3pane" ) == 0;
+}
+
+
+/*
+ *  Get a window property through the cache
+ */
+WindowCtrlUnix::PropertyValue   WindowCtrlUnix::getProperty( quint64 window, PropertyType property )
+{
+    QPair< quint64, long > key = qMakePair( window, m_property_atoms.at( property ) );
+
+    QHash< QPair< quint64, long >, PropertyValue >::const_iterator it = m_property_cache.constFind( key );
+    if( it != m_property_cache.constEnd() )
+    {
+        ++m_cache_hits;
+
+        return it.value();
+    }
+
+    ++m_cache_misses;
+
+    /*
+     *  Get notified of changes before reading, no change can slip in between.
+     *  The pid and role never change, they are read on every window without listening to it.
+     */
+    if( !isStaticProperty( key.second ) )
+    {
+        selectEvents( window, _PROPERTY_CHANGE_MASK );
+    }
+
+    int format;
+    qint32 length;
+    void* data = GetWindowPropertyAtom( m_display, window, key.second, &format, &length );
+
+    PropertyValue value;
+    if( data != nullptr )
+    {
+        int item_size = format == 32 ? sizeof( long ) : format / 8;
+
+        value.valid = true;
+        value.length = length;
+        value.data = QByteArray( reinterpret_cast< const char* >( data ), length * item_size );
+
+        Free( data );
+    }
+
+    m_property_cache.insert( key, value );
+
+    return value;
+}
+
+
+/*
+ *  Get the window position from the tracked geometry
+ */
+QPoint  WindowCtrlUnix::getWindowPositionTracked( quint64 window )
+{
+    QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( window );
+    if( record == m_tb_window_records.end() )
+    {
+        return QPoint();
+    }
+
+    WindowGeometry& geometry = record.value().geometry;
+    if( !record.value().geometry_valid )
+    {
+        /*
+         *  Not known yet, query once
+         */
+
+        int root_x;
+        int root_y;
+        int parent_x;
+        int parent_y;
+        GetWindowOrigin( m_display, window, &root_x, &root_y, &parent_x, &parent_y );
 
-    /*
-     *  Store the window state
-     */
-    m_tb_window_states[ window ] = Preferences::STATE_DOCKED;
+        geometry.root = QPoint( root_x, root_y );
+        geometry.offset = QPoint( parent_x, parent_y );
 
-    /*
-     *  Flush the pipes
-     */
-    Sync( m_display );
+        record.value().geometry_valid = true;
+    }
 
-#ifdef DEBUG_DISPLAY_ACTIONS_END
-    emit signalConsole( "Minimize to system tray done" );
-#endif
+    if( geometry.root.isNull() )
+    {
+        return QPoint();
+    }
+
+    return geometry.root - geometry.offset;
 }
 
 
 /*
- *  Normalize a window
+ *  Add events to the event mask of a window
  */
-void    WindowCtrlUnix::normalizeWindow( quint64 window )
+void    WindowCtrlUnix::selectEvents( quint64 window, long mask )
 {
-#if defined DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Normalize" );
-#endif
-
-    /*
-     *  Show window on taskbar and in the switcher
-     */
-    if( m_tb_window_states[ window ] == Preferences::STATE_DOCKED )
+    long old_mask = m_event_masks.value( window, 0 );
+    if( ( old_mask & mask ) != mask )
     {
-        MapWindow( m_display, window );
+        m_event_masks[ window ] = old_mask | mask;
+        SelectInput( m_display, window, old_mask | mask );
+    }
+}
 
-        /*
-         *  Reset the hide flags
-         */
-        SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_REMOVE, _ATOM_SKIP_TASKBAR );
-        SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_REMOVE, _ATOM_SKIP_PAGER );
 
-        /*
-         *  Was the window maximized?
-         */
-        if( m_tb_window_states_x11[ window ].contains( "_NET_WM_STATE_MAXIMIZED_VERT" ) &&
-                m_tb_window_states_x11[ window ].contains( "_NET_WM_STATE_MAXIMIZED_HORZ" ) )
+/*
+ *  Forget the cached data of windows that are gone
+ */
+void    WindowCtrlUnix::forgetWindows( const QSet< quint64 >& existing )
+{
+    QHash< QPair< quint64, long >, PropertyValue >::iterator it = m_property_cache.begin();
+    while( it != m_property_cache.end() )
+    {
+        if( !existing.contains( it.key().first ) )
+        {
+            it = m_property_cache.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    QHash< quint64, long >::iterator mask_it = m_event_masks.begin();
+    while( mask_it != m_event_masks.end() )
+    {
+        if( !existing.contains( mask_it.key() ) )
         {
-            SendEvent( m_display, window, "_NET_WM_STATE", _NET_WM_STATE_ADD, _ATOM_MAXIMIZED );
+            mask_it = m_event_masks.erase( mask_it );
         }
+        else
+        {
+            ++mask_it;
+        }
+    }
+}
 
-        /*
-         * Delete the X11 state
-         */
-        m_tb_window_states_x11.remove( window );
 
-        /*
-         *  Restore the size hints
-         */
-        SetWMNormalHints( m_display, window, m_tb_window_hints[ window ] );
+/*
+ *  Handle the X11 events
+ */
+void    WindowCtrlUnix::slotX11Events()
+{
+    processX11Events();
 
-        Flush( m_display );
+    if( m_identify_retry )
+    {
+        matchPendingWindows();
     }
+}
 
-    /*
-     *  Store the window state
-     */
-    m_tb_window_states[ window ] = Preferences::STATE_NORMAL;
 
-    /*
-     *  Raise the window to the top
-     */
-    MapRaised( m_display, window );
+/*
+ *  Process the pending X11 events
+ */
+void    WindowCtrlUnix::processX11Events()
+{
+    while( EventsPending( m_display ) > 0 )
+    {
+        WindowEvent event;
+        NextEvent( m_display, &event );
 
-    /*
-     *  Flush the pipes
-     */
-    Flush( m_display );
+        switch( event.type )
+        {
+            case _EVENT_PROPERTY_NOTIFY:
+            {
+                /*
+                 *  Invalidate the cached property
+                 */
+                m_property_cache.remove( qMakePair( event.window, event.atom ) );
 
-    /*
-     *  Get the current desktop
-     */
-    int current_desktop = 0;
+                /*
+                 *  New managed windows?
+                 */
+                if( event.window == m_root_window && event.atom == m_property_atoms.at( PROPERTY_NET_CLIENT_LIST ) )
+                {
+                    m_clients_changed = true;
+                }
 
-    qint32 n_current_desktop;
-    long* current_desktop_ptr = (long*)GetWindowProperty( m_display, 0, "_NET_CURRENT_DESKTOP", &n_current_desktop );
+                /*
+                 *  Title or client list change while waiting for a title token?
+                 */
+                if( !m_pending_identify.isEmpty() &&
+                        ( event.atom == m_property_atoms.at( PROPERTY_NET_WM_NAME ) ||
+                          event.atom == m_property_atoms.at( PROPERTY_NET_CLIENT_LIST ) ) )
+                {
+                    m_identify_retry = true;
+                }
 
-    if( current_desktop_ptr != nullptr )
-    {
-        /*
-         *  Store it
-         */
-        current_desktop = *current_desktop_ptr;
+                /*
+                 *  State change of a Thunderbird window, by us or by the user
+                 */
+                if( event.atom == m_property_atoms.at( PROPERTY_WM_STATE ) &&
+                        m_tb_window_records.contains( event.window ) )
+                {
+                    updateConfirmedState( event.window );
+                }
 
-        /*
-         *  Cleanup
-         */
-        Free( current_desktop_ptr );
+                /*
+                 *  Frame or maximize change of a Thunderbird window?
+                 */
+                if( m_tb_window_records.contains( event.window ) &&
+                        ( event.atom == m_property_atoms.at( PROPERTY_NET_FRAME_EXTENTS ) ||
+                          event.atom == m_property_atoms.at( PROPERTY_NET_WM_STATE ) ) )
+                {
+                    m_positions_timer->start();
+                }
+                break;
+            }
 
-        /*
-         *  Set the desktop for the window
-         */
-        SendEvent( m_display, window, "_NET_WM_DESKTOP", current_desktop, 1 );
+            case _EVENT_CONFIGURE_NOTIFY:
+            {
+                QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( event.window );
+                if( record != m_tb_window_records.end() && record.value().geometry_valid )
+                {
+                    WindowGeometry& geometry = record.value().geometry;
+
+                    if( event.send_event )
+                    {
+                        /*
+                         *  Synthetic event from the window manager, root coordinates
+                         */
+                        geometry.root = QPoint( event.x, event.y );
+                    }
+                    else
+                    {
+                        /*
+                         *  Real event, coordinates in the parent (frame). A resize from the top
+                         *  or left edge or a frame move does not tell the root position, query it
+                         *  again at the next read.
+                         */
+                        record.value().geometry_valid = false;
+                    }
+                }
+
+                if( record != m_tb_window_records.end() )
+                {
+                    m_positions_timer->start();
+                }
+                break;
+            }
+
+            case _EVENT_REPARENT_NOTIFY:
+            {
+                /*
+                 *  New frame, query the geometry again
+                 */
+                QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( event.window );
+                if( record != m_tb_window_records.end() )
+                {
+                    record.value().geometry_valid = false;
+                }
+                break;
+            }
+
+            case _EVENT_DESTROY_NOTIFY:
+            {
+                QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( event.window );
+                if( record != m_tb_window_records.end() )
+                {
+                    record.value().geometry_valid = false;
+                }
+
+                m_event_masks.remove( event.window );
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
     }
 
     /*
-     *  Normalize
+     *  Reading the events also delivered the errors
      */
-    SendEvent( m_display, window, "_NET_ACTIVE_WINDOW" );
+    collectErrors();
+}
 
-    /*
-     *  Flush the pipes
-     */
-    Sync( m_display );
 
-    /*
-     *  Force the window to the last known position?
-     */
-    if( m_pref->getWindowPositionsCorrection() )
+/*
+ *  Attribute the X11 errors to the operations and report the failed ones
+ */
+void    WindowCtrlUnix::collectErrors()
+{
+    X11Error errors[ X11_ERROR_BUFFER ];
+    int count = TakeErrors( errors );
+
+    for( int i = 0 ; i < count ; ++i )
     {
         /*
-         *  Move the window to the last recorded position
+         *  Find the operation that sent the failed request
          */
-        QPoint pos = m_tb_window_positions[ window ];
-        MoveWindow( m_display, window, pos.x(), pos.y() );
-        Flush( m_display );
+        int op = 0;
+        for( ; op < m_open_operations.length() ; ++op )
+        {
+            const OperationResult& result = m_open_operations.at( op );
+            if( errors[ i ].serial >= result.first_serial && errors[ i ].serial < result.last_serial )
+            {
+                break;
+            }
+        }
+
+        char text[ 256 ];
+        GetErrorText( m_display, errors[ i ].error_code, text, sizeof( text ) );
+
+        if( op == m_open_operations.length() )
+        {
+            ++m_unattributed_errors;
+
+            LOG_WARNING( QString( "X11 error outside operations: %1 (request %2, resource 0x%3)" )
+                         .arg( QString::fromLocal8Bit( text ) )
+                         .arg( errors[ i ].request_code )
+                         .arg( errors[ i ].resource, 0, 16 ) );
+            continue;
+        }
+
+        OperationError error;
+        error.resource = errors[ i ].resource;
+        error.error_code = errors[ i ].error_code;
+        error.request_code = errors[ i ].request_code;
+        error.text = QString::fromLocal8Bit( text );
+
+        m_open_operations[ op ].errors.append( error );
     }
 
     /*
-     *  Let us wait a bit, maybe this helps...
+     *  Report the operations whose requests have all been processed
      */
-#if QT_VERSION < QT_VERSION_CHECK(5, 4, 0)
-    QTime state_wait;
-#else
-    QElapsedTimer state_wait;
-#endif
-    state_wait.start();
+    unsigned long processed = GetLastProcessedSerial( m_display );
 
-    bool win_normal = false;
-    while( state_wait.elapsed() < 1000 && !win_normal )
+    QList< OperationResult >::iterator it = m_open_operations.begin();
+    while( it != m_open_operations.end() )
     {
-        /*
-         *  Get the WM_STATE
-         */
-        qint32 n_wm_state;
-        void* wm_state_ptr = GetWindowProperty( m_display, window, "WM_STATE", &n_wm_state );
+        if( processed < it->last_serial - 1 )
+        {
+            ++it;
+            continue;
+        }
 
-        /*
-         *  Get the state
-         */
-        int state = -1;
-        if( wm_state_ptr != nullptr )
+        if( !it->errors.isEmpty() )
         {
-            state = *reinterpret_cast<long *>( wm_state_ptr );
+            m_operation_stats[ it->type ].errors += it->errors.length();
+
+            /*
+             *  A failed window will not reach the requested state
+             */
+            for( int i = 0 ; i < it->errors.length() ; ++i )
+            {
+                if( m_confirm_pending.remove( it->errors.at( i ).resource ) > 0 )
+                {
+                    ++m_confirm_failed;
+                }
+
+                QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( it->errors.at( i ).resource );
+                if( record != m_tb_window_records.end() )
+                {
+                    record.value().requested = Preferences::STATE_UNKNOWN;
+                }
+            }
 
-            if( state == 1 )
+            for( int i = 0 ; i < it->errors.length() ; ++i )
             {
-                win_normal = true;
+                const OperationError& error = it->errors.at( i );
+                LOG_WARNING( QString( "%1 failed: %2 (request %3, resource 0x%4)" )
+                             .arg( OperationTypes.at( it->type ) )
+                             .arg( error.text )
+                             .arg( error.request_code )
+                             .arg( error.resource, 0, 16 ) );
             }
 
-            Free( wm_state_ptr );
+            emit signalOperationFailed( *it );
         }
-    }
 
-#ifdef DEBUG_DISPLAY_ACTIONS_END
-    emit signalConsole( "Normalize done" );
-#endif
+        it = m_open_operations.erase( it );
+    }
 }
 
 
@@ -709,9 +1830,163 @@ void    WindowCtrlUnix::normalizeWindow( quint64 window )
  */
 void    WindowCtrlUnix::deleteWindow( quint64 window )
 {
+    OperationStart start = beginOperation();
+
     SendEvent( m_display, window, "WM_PROTOCOLS", _ATOM_DELETE_WINDOW );
 
     Flush( m_display );
+
+    endOperation( OPERATION_DELETE, start );
+}
+
+
+/*
+ *  Send the X11 operation statistics to the console
+ */
+void    WindowCtrlUnix::dumpOperationStats()
+{
+    LOG_INFO( QString( "X11 totals: requests %1, round trips %2" )
+              .arg( GetRequestCount( m_display ) ).arg( GetRoundTripCount( m_display ) ) );
+    LOG_INFO( QString( "Property cache: entries %1, hits %2, misses %3" )
+              .arg( m_property_cache.count() ).arg( m_cache_hits ).arg( m_cache_misses ) );
+    LOG_INFO( QString( "X11 errors outside operations: %1" ).arg( m_unattributed_errors ) );
+
+    for( int i = 0 ; i < m_operation_stats.length() ; ++i )
+    {
+        const OperationStats& stats = m_operation_stats.at( i );
+
+        if( stats.count == 0 )
+        {
+            continue;
+        }
+
+        LOG_INFO( QString( "%1: count %2, requests %3, round trips %4, errors %5, avg %6 ms, max %7 ms" )
+                  .arg( OperationTypes.at( i ) )
+                  .arg( stats.count )
+                  .arg( stats.requests )
+                  .arg( stats.round_trips )
+                  .arg( stats.errors )
+                  .arg( stats.elapsed / 1000.0 / stats.count, 0, 'f', 2 )
+                  .arg( stats.max / 1000.0, 0, 'f', 2 ) );
+
+        /*
+         *  Latency histogram, skip the empty buckets
+         */
+        QStringList buckets;
+        for( int b = 0 ; b < stats.histogram.length() ; ++b )
+        {
+            if( stats.histogram.at( b ) > 0 )
+            {
+                QString range = b == 0 ? QString( "<1" ) : QString( ">=%1" ).arg( 1 << ( b - 1 ) );
+                buckets.append( QString( "%1ms: %2" ).arg( range ).arg( stats.histogram.at( b ) ) );
+            }
+        }
+
+        LOG_INFO( QString( "    %1" ).arg( buckets.join( ", " ) ) );
+    }
+}
+
+
+/*
+ *  Clear the X11 operation statistics
+ */
+void    WindowCtrlUnix::resetOperationStats()
+{
+    m_operation_stats = QVector< OperationStats >( OperationTypes.length() );
+    m_unattributed_errors = 0;
+}
+
+
+/*
+ *  Get the X11 statistics of an operation type
+ */
+WindowCtrlUnix::OperationStats  WindowCtrlUnix::getOperationStats( OperationType type ) const
+{
+    return m_operation_stats.at( type );
+}
+
+
+/*
+ *  Take a snapshot at the start of an operation
+ */
+WindowCtrlUnix::OperationStart  WindowCtrlUnix::beginOperation() const
+{
+    OperationStart start;
+    start.time = m_stats_clock.nsecsElapsed() / 1000;
+    start.requests = GetRequestCount( m_display );
+    start.round_trips = GetRoundTripCount( m_display );
+    start.serial = GetNextRequestSerial( m_display );
+    start.trace = Tracer::isEnabled() ? Tracer::now() : -1;
+
+    return start;
+}
+
+
+/*
+ *  Account the requests, round trips and time of an operation
+ */
+void    WindowCtrlUnix::endOperation( OperationType type, const OperationStart& start )
+{
+    qint64 elapsed = m_stats_clock.nsecsElapsed() / 1000 - start.time;
+
+    OperationStats& stats = m_operation_stats[ type ];
+    stats.count++;
+    stats.requests += GetRequestCount( m_display ) - start.requests;
+    stats.round_trips += GetRoundTripCount( m_display ) - start.round_trips;
+    stats.elapsed += elapsed;
+    stats.max = qMax( stats.max, elapsed );
+
+    /*
+     *  Find the bucket, bucket n holds [2^(n-1), 2^n) ms
+     */
+    int bucket = 0;
+    qint64 ms = elapsed / 1000;
+    while( ms > 0 && bucket < OPERATION_HISTOGRAM_BUCKETS - 1 )
+    {
+        ms >>= 1;
+        ++bucket;
+    }
+
+    stats.histogram[ bucket ]++;
+
+    /*
+     *  Record the operation in the trace
+     */
+    if( start.trace >= 0 && Tracer::isEnabled() )
+    {
+        Tracer::complete( OperationTypes.at( type ), "x11", start.trace, Tracer::now() - start.trace );
+    }
+
+    /*
+     *  Keep the request range until the server processed it
+     */
+    OperationResult result;
+    result.type = type;
+    result.first_serial = start.serial;
+    result.last_serial = GetNextRequestSerial( m_display );
+
+    if( result.last_serial != result.first_serial )
+    {
+        m_open_operations.append( result );
+
+        if( m_open_operations.length() > OPERATIONS_OPEN_MAX )
+        {
+            /*
+             *  Let the server process all requests, the errors are in and all operations close
+             */
+            Sync( m_display );
+            collectErrors();
+        }
+    }
+
+    /*
+     *  The replies of this operation may have brought events along. Xlib holds them in its
+     *  queue, the socket does not become readable again for them.
+     */
+    if( EventsQueued( m_display ) > 0 )
+    {
+        processX11Events();
+    }
 }
 
 
@@ -721,7 +1996,7 @@ void    WindowCtrlUnix::deleteWindow( quint64 window )
 void    WindowCtrlUnix::setPositions( QList< QPoint > window_positions )
 {
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Set positions" );
+    LOG_DEBUG( "Set positions" );
 #endif
 
     for( int i = 0 ; i < m_tb_windows.length() ; ++i )
@@ -729,13 +2004,18 @@ void    WindowCtrlUnix::setPositions( QList< QPoint > window_positions )
         quint64 window = m_tb_windows.at( i );
 
 #ifdef DEBUG_DISPLAY_ACTIONS_DETAILS
-        emit signalConsole( QString( "Set pos: %1, %2").arg( window_positions.at( i ).x() ).arg( window_positions.at( i ).y() ) );
+        LOG_DEBUG( QString( "Set pos: %1, %2").arg( window_positions.at( i ).x() ).arg( window_positions.at( i ).y() ) );
 #endif
 
         if( i < window_positions.length() ) {
             QPoint pos = window_positions.at( i );
 
-            m_tb_window_positions[ window ] = pos;
+            QHash< quint64, WindowRecord >::iterator record = m_tb_window_records.find( window );
+            if( record != m_tb_window_records.end() )
+            {
+                record.value().position = pos;
+            }
+
             MoveWindow( m_display, window, pos.x(), pos.y() );
         }
     }
@@ -743,7 +2023,7 @@ void    WindowCtrlUnix::setPositions( QList< QPoint > window_positions )
     Flush( m_display );
 
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Set positions done" );
+    LOG_DEBUG( "Set positions done" );
 #endif
 }
 
@@ -777,38 +2057,39 @@ QList< WindowCtrlUnix::WindowItem >   WindowCtrlUnix::listXWindows( void* displa
 /*
  *  Get the window state from X11
  */
-QStringList WindowCtrlUnix::getWindowStateX11( quint64 window )
+WindowCtrlUnix::WindowStatesX11 WindowCtrlUnix::getWindowStateX11( quint64 window )
 {
-    qint32 n_net_wm_state;
-    void* net_wm_state_ptr = GetWindowProperty( m_display, window, "_NET_WM_STATE", &n_net_wm_state );
+    PropertyValue prop_net_wm_state = getProperty( window, PROPERTY_NET_WM_STATE );
 
     /*
-     *  Get the atoms
+     *  Match the atoms with the known states
      */
-    QStringList atom_list;
-    if( net_wm_state_ptr != nullptr )
+    WindowStatesX11 states = 0;
+    if( prop_net_wm_state.valid )
     {
-        for( qint32 i = 0 ; i < n_net_wm_state ; ++i )
+        const long* atoms = reinterpret_cast< const long* >( prop_net_wm_state.data.constData() );
+        for( qint32 i = 0 ; i < prop_net_wm_state.length ; ++i )
         {
-             char* atom_name = GetAtomName( m_display, reinterpret_cast<long *>( net_wm_state_ptr )[ i ] );
+            int state = m_window_states_atoms.indexOf( atoms[ i ] );
+            if( state != -1 )
+            {
+                states |= ( 1u << state );
+            }
+        }
+    }
 
-             atom_list.append( atom_name );
+    return states;
+}
 
-             if( atom_name )
-             {
-                 Free( atom_name );
-             }
-        }
 
-        Free( net_wm_state_ptr );
-    }
 /*
-    for( int i = 0 ; i < atom_list.length() ; ++i )
-     {
-         emit signalConsole( QString( "Atom: %1").arg( atom_list.at( i ) ) );
-     }
-*/
-    return atom_list;
+ *  Is the window maximized in both directions
+ */
+bool    WindowCtrlUnix::isMaximizedX11( WindowStatesX11 states ) const
+{
+    WindowStatesX11 maximized = ( 1u << STATE_MAXIMIZED_VERT ) | ( 1u << STATE_MAXIMIZED_HORZ );
+
+    return ( states & maximized ) == maximized;
 }
 
 #endif // Q_OS_UNIX
@@ -20,19 +20,59 @@
 #include <QObject>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QByteArray>
 #include <QPoint>
 #include <QStringList>
+#include <QVector>
+#include <QElapsedTimer>
 
 /*
  *  Predefines
  */
 class QTimer;
+class QSocketNotifier;
 
 /*
  *  Monitor timeout (ms)
  */
 #define STATES_MONITOR_TIMEOUT  500
 
+/*
+ *  State confirmation poll interval and timeout per window (ms)
+ */
+#define STATES_CONFIRM_INTERVAL 20
+#define STATES_CONFIRM_TIMEOUT  1000
+
+/*
+ *  Debounce time for position updates after window moves (ms)
+ */
+#define POSITIONS_DEBOUNCE_TIMEOUT  500
+
+/*
+ *  Time to wait for a stamped window title before falling back (ms)
+ */
+#define IDENTIFY_TIMEOUT    2000
+
+/*
+ *  Number of operations waiting for their errors before syncing to close them
+ */
+#define OPERATIONS_OPEN_MAX 32
+
+/*
+ *  ICCCM WM_STATE values
+ */
+#define WM_STATE_WITHDRAWN  0
+#define WM_STATE_NORMAL     1
+#define WM_STATE_ICONIC     3
+
+/*
+ *  Number of latency histogram buckets, bucket n counts [2^(n-1), 2^n) ms
+ */
+#define OPERATION_HISTOGRAM_BUCKETS 16
+
 /**
  * @brief The WindowCtrlUnix class.
  */
@@ -93,20 +133,12 @@ class WindowCtrlUnix : public QObject
             STATE_DEMANDS_ATTENTION
         };
 
-        const QStringList WindowStates = {
-            "_NET_WM_STATE_MODAL",
-            "_NET_WM_STATE_STICKY",
-            "_NET_WM_STATE_MAXIMIZED_VERT",
-            "_NET_WM_STATE_MAXIMIZED_HORZ",
-            "_NET_WM_STATE_SHADED",
-            "_NET_WM_STATE_SKIP_TASKBAR",
-            "_NET_WM_STATE_SKIP_PAGER",
-            "_NET_WM_STATE_HIDDEN",
-            "_NET_WM_STATE_FULLSCREEN",
-            "_NET_WM_STATE_ABOVE",
-            "_NET_WM_STATE_BELOW",
-            "_NET_WM_STATE_DEMANDS_ATTENTION"
-        };
+        static const QStringList WindowStates;
+
+        /*
+         *  Window states X11 bitset, bit n is set for window state n
+         */
+        typedef quint32 WindowStatesX11;
 
         /*
          *  Window types
@@ -118,6 +150,180 @@ class WindowCtrlUnix : public QObject
             CHECK_ALL,
         };
 
+        /*
+         *  Instrumented window operations
+         */
+        enum OperationType
+        {
+            OPERATION_FIND = 0,
+            OPERATION_MINIMIZE,
+            OPERATION_NORMALIZE,
+            OPERATION_UPDATE_POSITIONS,
+            OPERATION_DELETE
+        };
+
+        static const QStringList OperationTypes;
+
+        /*
+         *  Cached window properties
+         */
+        enum PropertyType
+        {
+            PROPERTY_NET_WM_PID = 0,
+            PROPERTY_WM_WINDOW_ROLE,
+            PROPERTY_WM_STATE,
+            PROPERTY_NET_WM_STATE,
+            PROPERTY_NET_FRAME_EXTENTS,
+            PROPERTY_NET_CURRENT_DESKTOP,
+            PROPERTY_NET_CLIENT_LIST,
+            PROPERTY_NET_WM_NAME
+        };
+
+        static const QStringList CachedProperties;
+
+        /*
+         *  Cached property value, format 32 items are stored as longs
+         */
+        class PropertyValue
+        {
+            public:
+
+                PropertyValue()
+                {
+                    valid = false;
+                    length = 0;
+                }
+
+                bool        valid;
+                qint32      length;
+                QByteArray  data;
+        };
+
+        /*
+         *  Tracked window geometry
+         */
+        class WindowGeometry
+        {
+            public:
+
+                QPoint  root;
+                QPoint  offset;
+        };
+
+        /*
+         *  Bookkeeping of a Thunderbird window
+         */
+        class WindowRecord
+        {
+            public:
+
+                WindowRecord()
+                {
+                    state = Preferences::STATE_NORMAL;
+                    requested = Preferences::STATE_UNKNOWN;
+                    previous = Preferences::STATE_UNKNOWN;
+                    states_x11 = 0;
+                    hints = SizeHints();
+                    ref_id = -1;
+                    geometry_valid = false;
+                }
+
+                QPoint                      position;
+                Preferences::WindowState    state;
+                Preferences::WindowState    requested;
+                Preferences::WindowState    previous;
+                WindowStatesX11             states_x11;
+                SizeHints                   hints;
+                int                         ref_id;
+                bool                        geometry_valid;
+                WindowGeometry              geometry;
+        };
+
+        /*
+         *  Window waiting for the window manager to reach a WM_STATE
+         */
+        class ConfirmPending
+        {
+            public:
+
+                long    wm_state;
+                qint64  deadline;
+        };
+
+        /*
+         *  Operation start snapshot
+         */
+        class OperationStart
+        {
+            public:
+
+                qint64          time;
+                unsigned long   requests;
+                unsigned long   round_trips;
+                unsigned long   serial;
+                qint64          trace;
+        };
+
+        /*
+         *  X11 error of a failed request
+         */
+        class OperationError
+        {
+            public:
+
+                quint64 resource;
+                int     error_code;
+                int     request_code;
+                QString text;
+        };
+
+        /*
+         *  Result of an operation, errors attributed by request serial
+         */
+        class OperationResult
+        {
+            public:
+
+                OperationResult()
+                {
+                    type = OPERATION_FIND;
+                    first_serial = 0;
+                    last_serial = 0;
+                }
+
+                OperationType   type;
+                unsigned long   first_serial;
+                unsigned long   last_serial;
+                QList< OperationError > errors;
+        };
+
+        /*
+         *  Operation statistics
+         */
+        class OperationStats
+        {
+            public:
+
+                OperationStats()
+                {
+                    count = 0;
+                    requests = 0;
+                    round_trips = 0;
+                    errors = 0;
+                    elapsed = 0;
+                    max = 0;
+                    histogram = QVector< quint64 >( OPERATION_HISTOGRAM_BUCKETS, 0 );
+                }
+
+                quint64 count;
+                quint64 requests;
+                quint64 round_trips;
+                quint64 errors;
+                qint64  elapsed;
+                qint64  max;
+                QVector< quint64 >  histogram;
+        };
+
         /*
          *  Window list item
          */
@@ -144,6 +350,11 @@ class WindowCtrlUnix : public QObject
          */
         explicit WindowCtrlUnix( QObject *parent = nullptr );
 
+        /**
+         * @brief openDisplay. Open the X11 connection, call from the thread using it.
+         */
+        void    openDisplay();
+
         /**
          * @brief disableX11ErrorHandler. Disable the X11 error handler.
          */
@@ -191,6 +402,20 @@ class WindowCtrlUnix : public QObject
          */
         Preferences::CloseType    getCloseType() const;
 
+        /**
+         * @brief setWindowPositionsCorrection
+         *
+         *  @param state    Set the window positions correction state.
+         */
+        void    setWindowPositionsCorrection( bool state );
+
+        /**
+         * @brief setWindowPositionsCorrectionType
+         *
+         *  @param type     Set the window positions correction type.
+         */
+        void    setWindowPositionsCorrectionType( Preferences::WindowPositionsCorrectionType type );
+
         /**
          * @brief getPpid. Get the parent process id.
          *
@@ -230,6 +455,14 @@ class WindowCtrlUnix : public QObject
          */
         void    identifyWindow( int id );
 
+        /**
+         * @brief identifyWindow. Connect the TB window id to the X11 window with the token in its title.
+         *
+         *  @param id       The TB windows id.
+         *  @param token    The token in the window title.
+         */
+        void    identifyWindow( int id, const QString& token );
+
         /**
          * @brief getWinIds. Get the Thunderbird window IDs.
          *
@@ -242,7 +475,7 @@ class WindowCtrlUnix : public QObject
          *
          *  @return     The list of reference IDs.
          */
-        const QMap< int, quint64 >&    getRefIds() const;
+        QMap< int, quint64 >    getRefIds() const;
 
         /**
          * @brief removeRefId. Remove the TB window Id from the reference list.
@@ -252,13 +485,29 @@ class WindowCtrlUnix : public QObject
         void    removeRefId( int id );
 
         /**
-         * @brief getWindowState. Get the state of a TB windows.
+         * @brief getWindowState. Get the state of a TB windows, the requested state while not confirmed.
+         *
+         *  @param  window  Window ID.
+         *
+         *  @return     The window state, STATE_UNKNOWN for an unknown window.
+         */
+        Preferences::WindowState    getWindowState( const quint64 window ) const;
+
+        /**
+         * @brief isStatePending. Is a state request of the window waiting for the window manager.
          *
          *  @param  window  Window ID.
          *
-         *  @return     The window state.
+         *  @return     True if pending.
          */
-        const Preferences::WindowState&    getWindowState( const quint64 window );
+        bool    isStatePending( const quint64 window ) const;
+
+        /**
+         * @brief refreshWindowState. Update the state of a known TB window, without searching all windows.
+         *
+         *  @param  window  Window ID.
+         */
+        void    refreshWindowState( const quint64 window );
 
         /**
          * @brief updatePositions. Update the window positions.
@@ -286,6 +535,53 @@ class WindowCtrlUnix : public QObject
          */
         void    normalizeWindow( quint64 window );
 
+        /**
+         * @brief minimizeWindowsToTaskbar. Minimize windows to the taskbar in one batch.
+         *
+         *  @param windows      The windows.
+         */
+        void    minimizeWindowsToTaskbar( const QList< quint64 >& windows );
+
+        /**
+         * @brief minimizeWindowsToTray. Minimize windows to the tray in one batch.
+         *
+         *  @param windows      The windows.
+         */
+        void    minimizeWindowsToTray( const QList< quint64 >& windows );
+
+        /**
+         * @brief normalizeWindows. Normalize windows in one batch.
+         *
+         *  @param windows      The windows.
+         */
+        void    normalizeWindows( const QList< quint64 >& windows );
+
+        /**
+         * @brief isConfirmPending. Are window states waiting for confirmation.
+         *
+         *  @return     True if pending.
+         */
+        bool    isConfirmPending() const;
+
+        /**
+         * @brief dumpOperationStats. Send the X11 operation statistics to the console.
+         */
+        void    dumpOperationStats();
+
+        /**
+         * @brief resetOperationStats. Clear the X11 operation statistics.
+         */
+        void    resetOperationStats();
+
+        /**
+         * @brief getOperationStats. Get the X11 statistics of an operation type.
+         *
+         *  @param type     The operation type.
+         *
+         *  @return     The statistics.
+         */
+        OperationStats  getOperationStats( OperationType type ) const;
+
         /**
          * @brief deleteWindow. Delete the window.
          *
@@ -322,17 +618,199 @@ class WindowCtrlUnix : public QObject
          * @brief getWindowStateX11. Get the window state from X11
          *
          *  @param window   The window.
+         *
+         *  @return     The window states bitset.
          */
-        QStringList getWindowStateX11( quint64 window );
+        WindowStatesX11 getWindowStateX11( quint64 window );
 
-    signals:
+        /**
+         * @brief isMaximizedX11. Is the window maximized in both directions.
+         *
+         *  @param states   The window states bitset.
+         *
+         *  @return     True if maximized.
+         */
+        bool    isMaximizedX11( WindowStatesX11 states ) const;
+
+        /**
+         * @brief beginOperation. Take a snapshot at the start of an operation.
+         *
+         *  @return     The snapshot.
+         */
+        OperationStart  beginOperation() const;
+
+        /**
+         * @brief endOperation. Account the requests, round trips and time of an operation.
+         *
+         *  @param type     The operation.
+         *  @param start    The snapshot from the start of the operation.
+         */
+        void    endOperation( OperationType type, const OperationStart& start );
+
+        /**
+         * @brief internAtoms. Get the atoms of a list of names in one request.
+         *
+         *  @param names    The atom names.
+         *
+         *  @return     The atoms.
+         */
+        QVector< long > internAtoms( const QStringList& names );
+
+        /**
+         * @brief getProperty. Get a window property, cached until the property changes.
+         *
+         *  @param window   The window.
+         *  @param property The property.
+         *
+         *  @return     The property value.
+         */
+        PropertyValue   getProperty( quint64 window, PropertyType property );
+
+        /**
+         * @brief isStaticProperty. Is the property set once when the window is created.
+         *
+         *  @param atom     The property atom.
+         *
+         *  @return     True for the pid and role, these are cached without listening to the window.
+         */
+        bool    isStaticProperty( long atom ) const;
+
+        /**
+         * @brief refreshStaticProperties. Forget the missing pid and role of the managed windows.
+         */
+        void    refreshStaticProperties();
+
+        /**
+         * @brief is3PaneWindow. Is the window a Thunderbird main window.
+         *
+         *  @param window   The window.
+         *  @param pid      The Thunderbird pid.
+         *
+         *  @return     True if the pid matches and the role is 3pane.
+         */
+        bool    is3PaneWindow( quint64 window, qint64 pid );
+
+        /**
+         * @brief getWindowPositionTracked. Get the window position from the tracked geometry.
+         *
+         *  @param window   The window.
+         *
+         *  @return     The position.
+         */
+        QPoint  getWindowPositionTracked( quint64 window );
+
+        /**
+         * @brief selectEvents. Add events to the event mask of a window.
+         *
+         *  @param window   The window.
+         *  @param mask     The event mask.
+         */
+        void    selectEvents( quint64 window, long mask );
+
+        /**
+         * @brief forgetWindows. Drop the cached data of windows that are gone.
+         *
+         *  @param existing     The windows still existing.
+         */
+        void    forgetWindows( const QSet< quint64 >& existing );
+
+        /**
+         * @brief matchPendingWindows. Match the pending tokens against the client window titles.
+         */
+        void    matchPendingWindows();
+
+        /**
+         * @brief bindWindow. Connect a TB window id to a X11 window.
+         *
+         *  @param id       The TB windows id.
+         *  @param window   The X11 window.
+         */
+        void    bindWindow( int id, quint64 window );
+
+        /**
+         * @brief addWindow. Add a Thunderbird window, keeps the order and the records in step.
+         *
+         *  @param window   The X11 window.
+         *  @param record   The bookkeeping of the window.
+         *
+         *  @return     The stored record.
+         */
+        WindowRecord&   addWindow( quint64 window, const WindowRecord& record );
+
+        /**
+         * @brief clearWindows. Forget all Thunderbird windows.
+         */
+        void    clearWindows();
+
+        /**
+         * @brief processX11Events. Handle the pending X11 events.
+         */
+        void    processX11Events();
+
+        /**
+         * @brief collectErrors. Attribute the X11 errors to the operations and report the failed ones.
+         */
+        void    collectErrors();
+
+        /**
+         * @brief getWmStateX11. Get the ICCCM WM_STATE of a window.
+         *
+         *  @param window   The window.
+         *
+         *  @return     The WM_STATE, withdrawn if not set.
+         */
+        long    getWmStateX11( quint64 window );
+
+        /**
+         * @brief storeWindowStates. Store positions, hints and X11 states before hiding.
+         *
+         *  @param windows  The windows.
+         */
+        void    storeWindowStates( const QList< quint64 >& windows );
+
+        /**
+         * @brief startConfirm. Start waiting for the windows to reach a WM_STATE.
+         *
+         *  @param windows  The windows.
+         *  @param wm_state The expected WM_STATE.
+         */
+        void    startConfirm( const QList< quint64 >& windows, long wm_state );
+
+        /**
+         * @brief requestStates. Drop the duplicate requests and store the requested state.
+         *
+         *  @param windows  The windows.
+         *  @param state    The requested state.
+         *
+         *  @return     The windows that need the request.
+         */
+        QList< quint64 >    requestStates( const QList< quint64 >& windows, Preferences::WindowState state );
 
         /**
-         * @brief signalConsole. Send a console message.
+         * @brief updateConfirmedState. Update the confirmed state of a window from its WM_STATE.
          *
-         *  @param message      The message.
+         *  @param window   The window.
+         */
+        void    updateConfirmedState( quint64 window );
+
+    private slots:
+
+        /**
+         * @brief slotConfirmStates. Poll the pending window states.
          */
-        void    signalConsole( QString message );
+        void    slotConfirmStates();
+
+        /**
+         * @brief slotX11Events. Handle the X11 connection activity.
+         */
+        void    slotX11Events();
+
+        /**
+         * @brief slotIdentifyTimeout. Identify the unmatched windows by elimination.
+         */
+        void    slotIdentifyTimeout();
+
+    signals:
 
         /**
          * @brief signalPositions. Signal the new window position.
@@ -341,12 +819,27 @@ class WindowCtrlUnix : public QObject
          */
         void    signalPositions( QList< QPoint > positions );
 
-    protected:
+        /**
+         * @brief signalWindowsConfirmed. Signal the window manager followed the last actions.
+         *
+         *  @param confirmed    Number of windows that reached the requested state.
+         *  @param timed_out    Number of windows that did not.
+         */
+        void    signalWindowsConfirmed( int confirmed, int timed_out );
+
+        /**
+         * @brief signalWindowIdentified. Signal a TB window has been matched to its X11 window.
+         *
+         *  @param id   The TB window id.
+         */
+        void    signalWindowIdentified( int id );
 
         /**
-         * @brief m_pref. Pointer to the preferences storage.
+         * @brief signalOperationFailed. Signal an operation caused X11 errors.
+         *
+         *  @param result   The operation and its errors.
          */
-        Preferences*    m_pref;
+        void    signalOperationFailed( const WindowCtrlUnix::OperationResult& result );
 
    private:
 
@@ -356,34 +849,127 @@ class WindowCtrlUnix : public QObject
         void*    m_display;
 
         /**
-         * @brief m_tb_windows. The Thunderbird windows.
+         * @brief m_root_window. The root window.
+         */
+        quint64 m_root_window;
+
+        /**
+         * @brief m_x11_notifier. Notifier for X11 connection activity.
+         */
+        QSocketNotifier*    m_x11_notifier;
+
+        /**
+         * @brief m_property_atoms. The atoms of the cached properties, index is the property type.
+         */
+        QVector< long > m_property_atoms;
+
+        /**
+         * @brief m_property_cache. The cached properties by window and atom.
+         */
+        QHash< QPair< quint64, long >, PropertyValue >  m_property_cache;
+
+        /**
+         * @brief m_event_masks. The selected X11 events by window.
+         */
+        QHash< quint64, long >  m_event_masks;
+
+        /**
+         * @brief m_clients_changed. The managed windows changed since the missing pid and role were read.
+         */
+        bool    m_clients_changed;
+
+        /**
+         * @brief m_positions_timer. Debounce timer for the position updates.
+         */
+        QTimer* m_positions_timer;
+
+        /**
+         * @brief m_pending_identify. The title tokens waiting for a match and their TB window ids.
+         */
+        QMap< QString, int >    m_pending_identify;
+
+        /**
+         * @brief m_identify_retry. A title or the client list changed while tokens are pending.
+         */
+        bool    m_identify_retry;
+
+        /**
+         * @brief m_identify_timer. Fallback timer for the pending tokens.
+         */
+        QTimer* m_identify_timer;
+
+        /**
+         * @brief m_cache_hits. Number of property cache hits.
+         */
+        quint64 m_cache_hits;
+
+        /**
+         * @brief m_cache_misses. Number of property cache misses.
+         */
+        quint64 m_cache_misses;
+
+        /**
+         * @brief m_tb_windows. The Thunderbird windows in X11 tree order.
+         *
+         *  The startup positions are applied by index in this order, the record hash has none.
+         *  Only changed together with m_tb_window_records, by addWindow() and clearWindows().
          */
         QList< quint64 >    m_tb_windows;
 
         /**
-         * @brief m_tb_window_refs. The Thunderbird window ids referenced to x11 windows.
+         * @brief m_tb_window_records. The bookkeeping of the Thunderbird windows.
          */
-        QMap< int, quint64 >    m_tb_window_refs;
+        QHash< quint64, WindowRecord >  m_tb_window_records;
 
         /**
-         * @brief m_tb_window_positions. The Thunderbird window positions.
+         * @brief m_window_states_atoms. The atoms of the window states, index is the window state.
          */
-        QMap< quint64, QPoint >    m_tb_window_positions;
+        QVector< long > m_window_states_atoms;
 
         /**
-         * @brief m_tb_window_states. The Thunderbird window states.
+         * @brief m_stats_clock. Clock for the operation timing and the confirmation deadlines.
          */
-        QMap< quint64, Preferences::WindowState >    m_tb_window_states;
+        QElapsedTimer   m_stats_clock;
 
         /**
-         * @brief m_tb_window_states_x11. The Thunderbird window states X11.
+         * @brief m_operation_stats. The statistics per operation.
          */
-        QMap< quint64, QStringList >    m_tb_window_states_x11;
+        QVector< OperationStats >   m_operation_stats;
 
         /**
-         * @brief m_tb_window_hints. The Thunderbird window hints.
+         * @brief m_confirm_timer. Poll timer for the state confirmation.
          */
-        QMap< quint64, SizeHints >  m_tb_window_hints;
+        QTimer* m_confirm_timer;
+
+        /**
+         * @brief m_confirm_pending. The windows, their expected WM_STATE and deadline.
+         */
+        QMap< quint64, ConfirmPending > m_confirm_pending;
+
+        /**
+         * @brief m_confirm_timed_out. Number of windows timed out.
+         */
+        int m_confirm_timed_out;
+
+        /**
+         * @brief m_confirm_confirmed. Number of windows confirmed.
+         */
+        int m_confirm_confirmed;
+
+        /**
+         * @brief m_confirm_failed. Number of windows failed by an X11 error.
+         */
+        int m_confirm_failed;
+
+        /**
+         * @brief m_open_operations. The operations whose requests may still report errors.
+         */
+        QList< OperationResult >    m_open_operations;
+
+        /**
+         * @brief m_unattributed_errors. Number of X11 errors outside any operation.
+         */
+        quint64 m_unattributed_errors;
 
         /**
          * @brief m_minimize_type. Minimize type.
@@ -399,6 +985,16 @@ class WindowCtrlUnix : public QObject
          * @brief m_close_type. Close type.
          */
         Preferences::CloseType   m_close_type;
+
+        /**
+         * @brief m_window_positions_correction. Force the windows to the last known position.
+         */
+        bool    m_window_positions_correction;
+
+        /**
+         * @brief m_window_positions_correction_type. Window positions correction type.
+         */
+        Preferences::WindowPositionsCorrectionType  m_window_positions_correction_type;
 };
 
 #endif // WINDOWCTRLUNIX_H
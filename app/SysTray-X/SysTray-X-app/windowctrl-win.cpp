@@ -219,6 +219,26 @@ const Preferences::WindowState&    WindowCtrlWin::getWindowState( const quint64
 }
 
 
+/*
+ *  Update the state of a known TB window
+ */
+void    WindowCtrlWin::refreshWindowState( const quint64 window )
+{
+    WINDOWPLACEMENT wp;
+    wp.length = sizeof( WINDOWPLACEMENT );
+    GetWindowPlacement( (HWND)window, &wp );
+
+    if( SW_SHOWMINIMIZED == wp.showCmd )
+    {
+        m_tb_window_states[ window ] = Preferences::STATE_MINIMIZED;
+    }
+    else
+    {
+        m_tb_window_states[ window ] = Preferences::STATE_NORMAL;
+    }
+}
+
+
 /*
  *  Try to match the TB window id to a x11 window
  */
@@ -258,7 +278,7 @@ void    WindowCtrlWin::identifyWindow( int id )
 
     if( win_list.length() != 1 )
     {
-        //        emit signalConsole( QString( "Unexpected Ids: %1" ).arg( win_list.length() ) );
+        //        LOG_DEBUG( QString( "Unexpected Ids: %1" ).arg( win_list.length() ) );
     }
 }
 
@@ -320,6 +340,42 @@ void    WindowCtrlWin::normalizeWindow( quint64 window )
 }
 
 
+/*
+ *  Minimize windows to the taskbar
+ */
+void    WindowCtrlWin::minimizeWindowsToTaskbar( const QList< quint64 >& windows )
+{
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        minimizeWindowToTaskbar( windows.at( i ) );
+    }
+}
+
+
+/*
+ *  Minimize windows to the tray
+ */
+void    WindowCtrlWin::minimizeWindowsToTray( const QList< quint64 >& windows )
+{
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        minimizeWindowToTray( windows.at( i ) );
+    }
+}
+
+
+/*
+ *  Normalize windows
+ */
+void    WindowCtrlWin::normalizeWindows( const QList< quint64 >& windows )
+{
+    for( int i = 0 ; i < windows.length() ; ++i )
+    {
+        normalizeWindow( windows.at( i ) );
+    }
+}
+
+
 /*
  *  Normalize hidden windows
  */
@@ -166,6 +166,13 @@ class WindowCtrlWin : public QObject
          */
         const Preferences::WindowState&    getWindowState( const quint64 window );
 
+        /**
+         * @brief refreshWindowState. Update the state of a known TB window, without searching all windows.
+         *
+         *  @param  window  Window ID.
+         */
+        void    refreshWindowState( const quint64 window );
+
         /**
          * @brief getWinIds. Get the Thunderbird window IDs.
          *
@@ -208,6 +215,27 @@ class WindowCtrlWin : public QObject
          */
         void    normalizeWindow( quint64 window );
 
+        /**
+         * @brief minimizeWindowsToTaskbar. Minimize windows to the taskbar.
+         *
+         *  @param windows      The windows.
+         */
+        void    minimizeWindowsToTaskbar( const QList< quint64 >& windows );
+
+        /**
+         * @brief minimizeWindowsToTray. Minimize windows to the tray.
+         *
+         *  @param windows      The windows.
+         */
+        void    minimizeWindowsToTray( const QList< quint64 >& windows );
+
+        /**
+         * @brief normalizeWindows. Normalize windows.
+         *
+         *  @param windows      The windows.
+         */
+        void    normalizeWindows( const QList< quint64 >& windows );
+
         /**
          * @brief normalizeWindowsHidden. Normalize hidden windows.
          */
@@ -265,20 +293,6 @@ class WindowCtrlWin : public QObject
          */
         void signalWindowMinimize();
 
-        /**
-         * @brief signalConsole. Send a console message.
-         *
-         *  @param message      The message.
-         */
-        void    signalConsole( QString message );
-
-    protected:
-
-        /**
-         * @brief m_pref. Pointer to the preferences storage.
-         */
-        Preferences*    m_pref;
-
     private:
 
         /**
@@ -6,6 +6,7 @@
 #include <QWidget>
 #include <QWindow>
 #include <QCoreApplication>
+#include <QTimer>
 
 /*
  *  System includes
@@ -16,6 +17,7 @@
  */
 #include "debug.h"
 #include "preferences.h"
+#include "logger.h"
 
 /*
  *  Constructor
@@ -30,16 +32,9 @@ WindowCtrl::WindowCtrl( Preferences* pref, QObject *parent )
 #endif
 {
     /*
-     *  Store preferences
+     *  Initialize, the preferences are only read here, in the GUI thread
      */
-    m_pref = pref;
-
-    /*
-     *  Initialize
-     */
-    setMinimizeType( m_pref->getMinimizeType() );
-    setMinimizeIconType( m_pref->getMinimizeIconType() );
-    setCloseType( m_pref->getCloseType() );
+    applySettings( Preferences::ChangeSet( QFlag( ~0 ) ), pref->getWindowSettings() );
     m_show_hide_active = false;
 
     /*
@@ -49,9 +44,51 @@ WindowCtrl::WindowCtrl( Preferences* pref, QObject *parent )
     m_ppid = getPpid();
 
     /*
-     *  Get the TB windows
+     *  Register the types passed through queued connections
+     */
+    qRegisterMetaType< Preferences::WindowState >( "Preferences::WindowState" );
+    qRegisterMetaType< Preferences::ChangeSet >( "Preferences::ChangeSet" );
+    qRegisterMetaType< Preferences::WindowSettings >( "Preferences::WindowSettings" );
+    qRegisterMetaType< QList< QPoint > >( "QList<QPoint>" );
+
+#ifdef Q_OS_UNIX
+
+    /*
+     *  Setup the show / hide benchmark, driven by the window manager confirmations
+     */
+    m_bench_active = false;
+    m_bench_count = 0;
+    m_bench_step = BENCHMARK_SINGLE_MINIMIZE;
+    m_bench_single = 0;
+
+    m_bench_timer = new QTimer( this );
+    m_bench_timer->setSingleShot( true );
+    m_bench_timer->setInterval( BENCHMARK_STEP_TIMEOUT );
+    connect( m_bench_timer, &QTimer::timeout, this, &WindowCtrl::slotBenchmarkTimeout );
+
+    connect( this, &WindowCtrlUnix::signalWindowsConfirmed, this, &WindowCtrl::slotBenchmarkConfirmed );
+
+#endif
+}
+
+
+/*
+ *  Initialize, runs in the window control thread
+ */
+void    WindowCtrl::slotInitialize()
+{
+#ifdef Q_OS_UNIX
+
+    /*
+     *  The X11 connection is owned by this thread
+     */
+    openDisplay();
+
+#endif
+
+    /*
+     *  The TB windows are searched when first needed
      */
-    findWindows( m_ppid );
 }
 
 
@@ -69,24 +106,221 @@ bool    WindowCtrl::thunderbirdStart() const
  */
 void    WindowCtrl::slotWindowTest1()
 {
-    emit signalConsole("Test 1 started");
+#ifdef Q_OS_UNIX
 
-    // Do something.
+    if( m_bench_active )
+    {
+        LOG_DEBUG("Test 1 already running");
+        return;
+    }
+
+    LOG_DEBUG("Test 1 started");
+
+    /*
+     *  Benchmark minimize / normalize, single window calls versus batch.
+     *  Each step continues when the window manager confirmed the previous one,
+     *  the event loop is never entered recursively.
+     */
+    findWindows( m_ppid );
 
-    emit signalConsole("Test 1 done");
+    m_bench_windows = getWinIds();
+    if( m_bench_windows.isEmpty() )
+    {
+        LOG_DEBUG("Test 1 done");
+        return;
+    }
+
+    m_bench_active = true;
+    m_bench_count = 1;
+    m_bench_step = BENCHMARK_SINGLE_MINIMIZE;
+
+    runBenchmarkStep();
+
+#else
+
+    LOG_DEBUG("Test 1 started");
+    LOG_DEBUG("Test 1 done");
+
+#endif
 }
 
 
+/*
+ *  Handle the confirmation of a benchmark step
+ */
+void    WindowCtrl::slotBenchmarkConfirmed()
+{
+#ifdef Q_OS_UNIX
+
+    if( !m_bench_active || isConfirmPending() )
+    {
+        return;
+    }
+
+    m_bench_timer->stop();
+
+    nextBenchmarkStep();
+
+#endif
+}
+
+
+/*
+ *  Handle a benchmark step not confirmed in time
+ */
+void    WindowCtrl::slotBenchmarkTimeout()
+{
+#ifdef Q_OS_UNIX
+
+    if( !m_bench_active )
+    {
+        return;
+    }
+
+    LOG_WARNING( QString( "Test 1 step %1 with %2 windows not confirmed in time" ).arg( m_bench_step ).arg( m_bench_count ) );
+
+    stopBenchmark();
+
+#endif
+}
+
+
+#ifdef Q_OS_UNIX
+
+/*
+ *  Start the actions of the current benchmark step
+ */
+void    WindowCtrl::runBenchmarkStep()
+{
+    QList< quint64 > windows = m_bench_windows.mid( 0, m_bench_count );
+
+    switch( m_bench_step )
+    {
+        case BENCHMARK_SINGLE_MINIMIZE:
+        {
+            m_bench_clock.start();
+
+            for( int i = 0 ; i < windows.length() ; ++i )
+            {
+                minimizeWindowToTaskbar( windows.at( i ) );
+            }
+            break;
+        }
+
+        case BENCHMARK_SINGLE_NORMALIZE:
+        {
+            for( int i = 0 ; i < windows.length() ; ++i )
+            {
+                normalizeWindow( windows.at( i ) );
+            }
+            break;
+        }
+
+        case BENCHMARK_BATCH_MINIMIZE:
+        {
+            m_bench_clock.restart();
+
+            minimizeWindowsToTaskbar( windows );
+            break;
+        }
+
+        case BENCHMARK_BATCH_NORMALIZE:
+        {
+            normalizeWindows( windows );
+            break;
+        }
+    }
+
+    if( isConfirmPending() )
+    {
+        /*
+         *  Continue in slotBenchmarkConfirmed
+         */
+        m_bench_timer->start();
+    }
+    else
+    {
+        /*
+         *  Nothing to wait for
+         */
+        nextBenchmarkStep();
+    }
+}
+
+
+/*
+ *  Account the current benchmark step and start the next one
+ */
+void    WindowCtrl::nextBenchmarkStep()
+{
+    switch( m_bench_step )
+    {
+        case BENCHMARK_SINGLE_MINIMIZE:
+        {
+            m_bench_step = BENCHMARK_SINGLE_NORMALIZE;
+            break;
+        }
+
+        case BENCHMARK_SINGLE_NORMALIZE:
+        {
+            m_bench_single = m_bench_clock.elapsed();
+            m_bench_step = BENCHMARK_BATCH_MINIMIZE;
+            break;
+        }
+
+        case BENCHMARK_BATCH_MINIMIZE:
+        {
+            m_bench_step = BENCHMARK_BATCH_NORMALIZE;
+            break;
+        }
+
+        case BENCHMARK_BATCH_NORMALIZE:
+        {
+            qint64 batch = m_bench_clock.elapsed();
+
+            LOG_DEBUG( QString( "Windows: %1, single: %2 ms, batch: %3 ms" ).arg( m_bench_count ).arg( m_bench_single ).arg( batch ) );
+
+            ++m_bench_count;
+            if( m_bench_count > m_bench_windows.length() )
+            {
+                stopBenchmark();
+                return;
+            }
+
+            m_bench_step = BENCHMARK_SINGLE_MINIMIZE;
+            break;
+        }
+    }
+
+    runBenchmarkStep();
+}
+
+
+/*
+ *  End the benchmark
+ */
+void    WindowCtrl::stopBenchmark()
+{
+    m_bench_timer->stop();
+    m_bench_active = false;
+    m_bench_windows.clear();
+
+    LOG_DEBUG("Test 1 done");
+}
+
+#endif
+
+
 /*
  *  Test func 2
  */
 void    WindowCtrl::slotWindowTest2()
 {
-    emit signalConsole("Test 2 started");
+    LOG_DEBUG("Test 2 started");
 
     // Do something.
 
-    emit signalConsole("Test 2 done");
+    LOG_DEBUG("Test 2 done");
 }
 
 
@@ -95,11 +329,11 @@ void    WindowCtrl::slotWindowTest2()
  */
 void    WindowCtrl::slotWindowTest3()
 {
-    emit signalConsole("Test 3 started");
+    LOG_DEBUG("Test 3 started");
 
     // Do something.
 
-    emit signalConsole("Test 3 done");
+    LOG_DEBUG("Test 3 done");
 }
 
 
@@ -108,35 +342,68 @@ void    WindowCtrl::slotWindowTest3()
  */
 void    WindowCtrl::slotWindowTest4()
 {
-    emit signalConsole("Test 4 started");
+    LOG_DEBUG("Test 4 started");
 
     // Do something.
 
-    emit signalConsole("Test 4 done");
+    LOG_DEBUG("Test 4 done");
 }
 
 /*
- *  Handle change in minimize type change
+ *  Dump the window operation statistics
  */
-void    WindowCtrl::slotMinimizeTypeChange()
+void    WindowCtrl::slotDumpStats()
 {
-    setMinimizeType( m_pref->getMinimizeType() );
+#ifdef Q_OS_UNIX
+
+    dumpOperationStats();
+
+#endif
 }
 
+
 /*
- *  Handle change in minimize icon type change
+ *  Handle a preferences change set
  */
-void    WindowCtrl::slotMinimizeIconTypeChange()
+void    WindowCtrl::slotPreferencesChanged( Preferences::ChangeSet changes, Preferences::WindowSettings settings )
 {
-    setMinimizeIconType( m_pref->getMinimizeIconType() );
+    applySettings( changes, settings );
 }
 
+
 /*
- *  Handle change in close type change
+ *  Apply the changed window control preferences
  */
-void    WindowCtrl::slotCloseTypeChange()
+void    WindowCtrl::applySettings( Preferences::ChangeSet changes, const Preferences::WindowSettings& settings )
 {
-    setCloseType( m_pref->getCloseType() );
+    if( changes.testFlag( Preferences::CHANGE_MINIMIZE_TYPE ) )
+    {
+        setMinimizeType( settings.minimize_type );
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_MINIMIZE_ICON_TYPE ) )
+    {
+        setMinimizeIconType( settings.minimize_icon_type );
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_CLOSE_TYPE ) )
+    {
+        setCloseType( settings.close_type );
+    }
+
+#ifdef Q_OS_UNIX
+
+    if( changes.testFlag( Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION ) )
+    {
+        setWindowPositionsCorrection( settings.window_positions_correction );
+    }
+
+    if( changes.testFlag( Preferences::CHANGE_WINDOW_POSITIONS_CORRECTION_TYPE ) )
+    {
+        setWindowPositionsCorrectionType( settings.window_positions_correction_type );
+    }
+
+#endif
 }
 
 
@@ -148,20 +415,32 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
     if( m_show_hide_active )
     {
 #ifdef DEBUG_DISPLAY_ACTIONS
-        emit signalConsole( "State change blocked" );
+        LOG_DEBUG( "State change blocked" );
 #endif
         return;
     }
 
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( QString( "State: %1" ).arg( Preferences::WindowStateString.at( state ) ) );
-    emit signalConsole( QString( "Id: %1" ).arg( id ) );
+    LOG_DEBUG( QString( "State: %1" ).arg( Preferences::WindowStateString.at( state ) ) );
+    LOG_DEBUG( QString( "Id: %1" ).arg( id ) );
 #endif
 
     /*
-     *  Update the TB windows and states
+     *  The add-on only reports changed windows, search all windows only for an unknown one
      */
-    findWindows( m_ppid );
+    QMap< int, quint64 > ref_list = getRefIds();
+
+    if( state == Preferences::STATE_MINIMIZED_STARTUP || state == Preferences::STATE_DOCKED_STARTUP ||
+            !ref_list.contains( id ) )
+    {
+        findWindows( m_ppid );
+
+        ref_list = getRefIds();
+    }
+    else
+    {
+        refreshWindowState( ref_list[ id ] );
+    }
 
     /*
      *  Minimize/dock all?
@@ -169,7 +448,7 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
     if( state == Preferences::STATE_MINIMIZED_STARTUP || state == Preferences::STATE_DOCKED_STARTUP )
     {
 #ifdef DEBUG_DISPLAY_ACTIONS
-        emit signalConsole( QString( "Minimize all" ) );
+        LOG_DEBUG( QString( "Minimize all" ) );
 #endif
 
         QList< quint64 > win_ids = getWinIds();
@@ -177,16 +456,13 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
         /*
          *   Minimize/dock all
          */
-        for( int i = 0 ; i < win_ids.length() ; ++i )
+        if( state == Preferences::STATE_MINIMIZED_STARTUP )
         {
-            if( state == Preferences::STATE_MINIMIZED_STARTUP )
-            {
-                minimizeWindowToTaskbar( win_ids.at( i ) );
-            }
-            else
-            {
-                minimizeWindowToTray( win_ids.at( i ) );
-            }
+            minimizeWindowsToTaskbar( win_ids );
+        }
+        else
+        {
+            minimizeWindowsToTray( win_ids );
         }
     }
     else
@@ -196,10 +472,21 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
             Preferences::MinimizeType minimize_type = getMinimizeType();
             if( minimize_type != Preferences::PREF_DEFAULT_MINIMIZE )
             {
-                QMap< int, quint64 > ref_list = getRefIds();
-
                 if( ref_list.contains( id ) )
                 {
+#ifdef Q_OS_UNIX
+                    /*
+                     *  Echo of our own request?
+                     */
+                    if( isStatePending( ref_list[ id ] ) )
+                    {
+#ifdef DEBUG_DISPLAY_ACTIONS
+                        LOG_DEBUG( "State change pending, dropped" );
+#endif
+                        return;
+                    }
+#endif
+
                     /*
                      *  Hide the window
                      */
@@ -213,7 +500,7 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
     }
 
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "State change done" );
+    LOG_DEBUG( "State change done" );
 #endif
 }
 
@@ -224,7 +511,7 @@ void    WindowCtrl::slotWindowState( Preferences::WindowState state, int id )
 void    WindowCtrl::slotShowHide()
 {
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Show/Hide" );
+    LOG_DEBUG( "Show/Hide" );
 #endif
 
     /*
@@ -257,28 +544,46 @@ void    WindowCtrl::slotShowHide()
      */
     QList< quint64 > win_ids = getWinIds();
 
+    /*
+     *  Sort the windows by action
+     */
+    QList< quint64 > normalize_ids;
+    QList< quint64 > minimize_ids;
     for( int i = 0 ; i < win_ids.length() ; ++i )
     {
 #ifdef DEBUG_DISPLAY_ACTIONS
-        emit signalConsole( QString( "Window state: %1, %2" )
-                            .arg( win_ids.at( i ) )
-                            .arg( Preferences::WindowStateString.at( getWindowState( win_ids.at( i ) ) ) ) );
+        LOG_DEBUG( QString( "Window state: %1, %2" )
+                   .arg( win_ids.at( i ) )
+                   .arg( Preferences::WindowStateString.at( getWindowState( win_ids.at( i ) ) ) ) );
 #endif
 
         if( getWindowState( win_ids.at( i ) ) == Preferences::STATE_MINIMIZED || getWindowState( win_ids.at( i ) ) == Preferences::STATE_DOCKED )
         {
-            normalizeWindow( win_ids.at( i ) );
+            normalize_ids.append( win_ids.at( i ) );
         }
         else
         {
-            if( target_type == TargetType::TYPE_WINDOW_TO_TASKBAR )
-            {
-                minimizeWindowToTaskbar( win_ids.at( i ) );
-            }
-            else
-            {
-                minimizeWindowToTray( win_ids.at( i ) );
-            }
+            minimize_ids.append( win_ids.at( i ) );
+        }
+    }
+
+    /*
+     *  Handle each action in one batch
+     */
+    if( !normalize_ids.isEmpty() )
+    {
+        normalizeWindows( normalize_ids );
+    }
+
+    if( !minimize_ids.isEmpty() )
+    {
+        if( target_type == TargetType::TYPE_WINDOW_TO_TASKBAR )
+        {
+            minimizeWindowsToTaskbar( minimize_ids );
+        }
+        else
+        {
+            minimizeWindowsToTray( minimize_ids );
         }
     }
 
@@ -288,7 +593,7 @@ void    WindowCtrl::slotShowHide()
     m_show_hide_active = false;
 
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Show/Hide end" );
+    LOG_DEBUG( "Show/Hide end" );
 #endif
 }
 
@@ -299,7 +604,7 @@ void    WindowCtrl::slotShowHide()
 void    WindowCtrl::slotClose()
 {
 #ifdef DEBUG_DISPLAY_ACTIONS
-    emit signalConsole( "Close" );
+    LOG_DEBUG( "Close" );
 #endif
 
 #ifdef Q_OS_WIN
@@ -352,15 +657,27 @@ void    WindowCtrl::slotPositions( QList< QPoint > window_positions )
 /*
  *  Handle the new window id.
  */
-void    WindowCtrl::slotNewWindow( int id )
+void    WindowCtrl::slotNewWindow( int id, QString token )
 {
-    /*
-     *  Get the windows
-     */
-    findWindows( m_ppid );
+#ifdef Q_OS_UNIX
+
+    if( !token.isEmpty() )
+    {
+        /*
+         *  Match the token in the window title
+         */
+        identifyWindow( id, token );
+        return;
+    }
+
+#else
+
+    Q_UNUSED( token )
+
+#endif
 
     /*
-     *  Try to find a corresponding x11 window
+     *  Try to find a corresponding window by elimination
      */
     identifyWindow( id );
 }
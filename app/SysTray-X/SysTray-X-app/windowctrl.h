@@ -7,6 +7,8 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QPoint>
+#include <QList>
+#include <QElapsedTimer>
 
 /*
  *	Local includes
@@ -20,10 +22,16 @@
 #endif // Q_OS_WIN
 
 
+/*
+ *  Time to wait for the window manager to confirm a benchmark step (ms)
+ */
+#define BENCHMARK_STEP_TIMEOUT  5000
+
 /*
  *  Predefines
  */
 class QWindow;
+class QTimer;
 
 /**
  * @brief The WindowCtrl class.
@@ -60,6 +68,11 @@ class WindowCtrl : public QObject
 
     public slots:
 
+        /**
+         * @brief slotInitialize. Initialize the window control in its own thread.
+         */
+        void    slotInitialize();
+
         /**
          * @brief slotWindowTest1. Start a test.
          */
@@ -81,19 +94,17 @@ class WindowCtrl : public QObject
         void    slotWindowTest4();
 
         /**
-         * @brief slotMinimizeTypeChange. Handle the minimize type signal.
+         * @brief slotDumpStats. Dump the window operation statistics.
          */
-        void    slotMinimizeTypeChange();
+        void    slotDumpStats();
 
         /**
-         * @brief slotMinimizeIconTypeChange. Handle the minimize icon type signal.
-         */
-        void    slotMinimizeIconTypeChange();
-
-        /**
-         * @brief slotCloseTypeChange. Handle the close type signal.
+         * @brief slotPreferencesChanged. Slot for handling a preferences change set.
+         *
+         *  @param changes      The changed preferences.
+         *  @param settings     Copy of the window control preferences.
          */
-        void    slotCloseTypeChange();
+        void    slotPreferencesChanged( Preferences::ChangeSet changes, Preferences::WindowSettings settings );
 
         /**
          * @brief slotWindowState. Handle the window state change signal.
@@ -121,9 +132,10 @@ class WindowCtrl : public QObject
         /**
          * @brief slotNewWindow. Slot for handling a new window.
          *
-         *  @param id   The TB window id.
+         *  @param id       The TB window id.
+         *  @param token    The token in the window title, empty if not stamped.
          */
-        void    slotNewWindow( int id );
+        void    slotNewWindow( int id, QString token );
 
         /**
          * @brief slotCloseWindow. Slot for handling a close window.
@@ -133,8 +145,93 @@ class WindowCtrl : public QObject
          */
         void    slotCloseWindow( int id, bool quit );
 
+    private slots:
+
+        /**
+         * @brief slotBenchmarkConfirmed. Handle the confirmation of a benchmark step.
+         */
+        void    slotBenchmarkConfirmed();
+
+        /**
+         * @brief slotBenchmarkTimeout. Handle a benchmark step not confirmed in time.
+         */
+        void    slotBenchmarkTimeout();
+
     private:
 
+        /*
+         *  Steps of the show / hide benchmark
+         */
+        enum BenchmarkStep
+        {
+            BENCHMARK_SINGLE_MINIMIZE = 0,
+            BENCHMARK_SINGLE_NORMALIZE,
+            BENCHMARK_BATCH_MINIMIZE,
+            BENCHMARK_BATCH_NORMALIZE
+        };
+
+        /**
+         * @brief applySettings. Apply the changed window control preferences.
+         *
+         *  @param changes      The changed preferences.
+         *  @param settings     Copy of the window control preferences.
+         */
+        void    applySettings( Preferences::ChangeSet changes, const Preferences::WindowSettings& settings );
+
+#ifdef Q_OS_UNIX
+
+        /**
+         * @brief runBenchmarkStep. Start the actions of the current benchmark step.
+         */
+        void    runBenchmarkStep();
+
+        /**
+         * @brief nextBenchmarkStep. Account the current benchmark step and start the next one.
+         */
+        void    nextBenchmarkStep();
+
+        /**
+         * @brief stopBenchmark. End the benchmark.
+         */
+        void    stopBenchmark();
+
+        /**
+         * @brief m_bench_active. The benchmark is running.
+         */
+        bool    m_bench_active;
+
+        /**
+         * @brief m_bench_windows. The windows of the benchmark.
+         */
+        QList< quint64 >    m_bench_windows;
+
+        /**
+         * @brief m_bench_count. Number of windows in the current cycle.
+         */
+        int     m_bench_count;
+
+        /**
+         * @brief m_bench_step. The current step.
+         */
+        BenchmarkStep   m_bench_step;
+
+        /**
+         * @brief m_bench_clock. Clock for the cycle timing.
+         */
+        QElapsedTimer   m_bench_clock;
+
+        /**
+         * @brief m_bench_single. Time of the single window cycle (ms).
+         */
+        qint64  m_bench_single;
+
+        /**
+         * @brief m_bench_timer. Bounds the wait for a confirmation.
+         */
+        QTimer* m_bench_timer;
+
+#endif
+
         /**
          * @brief m_show_hide_active
          */
@@ -0,0 +1,53 @@
+#
+#   Get the defaults
+#
+include( ../SysTray-X.pri )
+
+#
+#   Window control benchmark and regression check.
+#   Needs an X server with an EWMH window manager, run it with run-benchmark.sh
+#
+QT += core gui widgets
+
+TARGET = SysTray-X-bench
+TEMPLATE = app
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+#
+#   Add local includes
+#
+QMAKE_CFLAGS += -I$${_PRO_FILE_PWD_}/../SysTray-X-app -I$${_PRO_FILE_PWD_}/../SysTray-X-lib-x11
+QMAKE_CXXFLAGS += -I$${_PRO_FILE_PWD_}/../SysTray-X-app -I$${_PRO_FILE_PWD_}/../SysTray-X-lib-x11
+
+#
+#   Add local libs
+#
+LIBS += -L../SysTray-X-lib-x11 -lSysTray-X-x11
+
+#
+#   Add system libs
+#
+LIBS += -lX11
+
+SOURCES += \
+        benchmark.cpp \
+        main.cpp \
+        testwindows.cpp \
+        ../SysTray-X-app/logger.cpp \
+        ../SysTray-X-app/preferences.cpp \
+        ../SysTray-X-app/tracer.cpp \
+        ../SysTray-X-app/windowctrl.cpp \
+        ../SysTray-X-app/windowctrl-unix.cpp
+
+HEADERS += \
+        benchmark.h \
+        testwindows.h \
+        ../SysTray-X-app/logger.h \
+        ../SysTray-X-app/preferences.h \
+        ../SysTray-X-app/tracer.h \
+        ../SysTray-X-app/windowctrl.h \
+        ../SysTray-X-app/windowctrl-unix.h
@@ -0,0 +1,372 @@
+#include "benchmark.h"
+
+/*
+ *	Local includes
+ */
+#include "testwindows.h"
+#include "preferences.h"
+#include "logger.h"
+
+/*
+ *	System includes
+ */
+#include <stdio.h>
+
+/*
+ *	Qt includes
+ */
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTimer>
+
+
+/*
+ *  Constructor
+ */
+WindowCtrlBenchmark::WindowCtrlBenchmark( QObject* parent ) : QObject( parent )
+{
+    m_display = nullptr;
+    m_confirm_loop = nullptr;
+    m_confirmed = false;
+    m_timed_out = 0;
+    m_failures = 0;
+
+    /*
+     *  Hide to the taskbar, the test windows have no tray
+     */
+    m_preferences = new Preferences( this );
+    m_preferences->setMinimizeIconType( Preferences::PREF_DEFAULT_MINIMIZE_ICON );
+
+    m_win_ctrl = new WindowCtrl( m_preferences, this );
+
+    connect( m_win_ctrl, &WindowCtrlUnix::signalWindowsConfirmed, this, &WindowCtrlBenchmark::slotWindowsConfirmed );
+}
+
+
+/*
+ *  Destructor
+ */
+WindowCtrlBenchmark::~WindowCtrlBenchmark()
+{
+    if( m_display )
+    {
+        destroyWindows();
+
+        CloseTestDisplay( m_display );
+    }
+}
+
+
+/*
+ *  Run the benchmark
+ */
+int WindowCtrlBenchmark::run()
+{
+    m_display = OpenTestDisplay();
+    if( !m_display )
+    {
+        fprintf( stderr, "Cannot open the display\n" );
+
+        return 2;
+    }
+
+    m_win_ctrl->slotInitialize();
+
+    printf( "%4s %5s %6s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+            "N", "M", "found", "find us", "find rt", "cached us", "cached rt",
+            "set us", "update us", "update rt", "hide/show", "min/norm rt" );
+
+    QMap< int, Result > base;
+    for( int m = 0 ; m < m_n_other.length() ; ++m )
+    {
+        for( int n = 0 ; n < m_n_3pane.length() ; ++n )
+        {
+            Result result = measure( m_n_3pane.at( n ), m_n_other.at( m ) );
+
+            printf( "%4d %5d %6d %10lld %10llu %10lld %10llu %10lld %10lld %10llu %8lldms %6llu/%llu\n",
+                    result.n, result.m, result.found,
+                    result.find_time, result.find_round_trips,
+                    result.find_cached_time, result.find_cached_round_trips,
+                    result.set_time, result.update_time, result.update_round_trips,
+                    result.show_hide_time, result.minimize_round_trips, result.normalize_round_trips );
+            fflush( stdout );
+
+            if( result.m == 0 )
+            {
+                base.insert( result.n, result );
+            }
+
+            verify( result, base.value( result.n ) );
+        }
+    }
+
+    /*
+     *  Show the warnings and errors of the window control
+     */
+    quint64 next = Logger::tail();
+    QStringList lines = Logger::readLines( next );
+    for( int i = 0 ; i < lines.length() ; ++i )
+    {
+        fprintf( stderr, "%s\n", lines.at( i ).toLocal8Bit().constData() );
+    }
+
+    if( m_failures > 0 )
+    {
+        fprintf( stderr, "%d limits exceeded\n", m_failures );
+
+        return 1;
+    }
+
+    printf( "All limits met\n" );
+
+    return 0;
+}
+
+
+/*
+ *  Measure one N, M combination
+ */
+WindowCtrlBenchmark::Result WindowCtrlBenchmark::measure( int n, int m )
+{
+    Result result;
+    result.n = n;
+    result.m = m;
+
+    createWindows( n, m );
+
+    m_win_ctrl->resetOperationStats();
+
+    /*
+     *  The 3pane windows carry the pid of our parent, as Thunderbird does
+     */
+    qint64 pid = m_win_ctrl->getPpid();
+
+    QElapsedTimer timer;
+    timer.start();
+    m_win_ctrl->findWindows( pid );
+    result.find_time = timer.nsecsElapsed() / 1000;
+    result.find_round_trips = roundTrips( WindowCtrlUnix::OPERATION_FIND );
+    result.found = m_win_ctrl->getWinIds().length();
+
+    /*
+     *  Again, the properties are cached now
+     */
+    timer.restart();
+    m_win_ctrl->findWindows( pid );
+    result.find_cached_time = timer.nsecsElapsed() / 1000;
+    result.find_cached_round_trips = roundTrips( WindowCtrlUnix::OPERATION_FIND ) - result.find_round_trips;
+
+    QList< QPoint > positions;
+    for( int i = 0 ; i < result.found ; ++i )
+    {
+        positions.append( QPoint( 20 * i, 20 * i ) );
+    }
+
+    timer.restart();
+    m_win_ctrl->setPositions( positions );
+    result.set_time = timer.nsecsElapsed() / 1000;
+
+    timer.restart();
+    m_win_ctrl->updatePositions();
+    result.update_time = timer.nsecsElapsed() / 1000;
+    result.update_round_trips = roundTrips( WindowCtrlUnix::OPERATION_UPDATE_POSITIONS );
+
+    timer.restart();
+    showHide();
+    result.show_hide_time = timer.elapsed();
+    result.minimize_round_trips = roundTrips( WindowCtrlUnix::OPERATION_MINIMIZE );
+    result.normalize_round_trips = roundTrips( WindowCtrlUnix::OPERATION_NORMALIZE );
+    result.timed_out = m_timed_out;
+
+    destroyWindows();
+
+    return result;
+}
+
+
+/*
+ *  Check the measurements against the limits
+ */
+void    WindowCtrlBenchmark::verify( const Result& result, const Result& base )
+{
+    QString label = QString( "N %1, M %2: " ).arg( result.n ).arg( result.m );
+
+    check( result.found == result.n, label + QString( "found %1 windows" ).arg( result.found ) );
+    check( m_confirmed && result.timed_out == 0, label + QString( "hide/show not confirmed, %1 timed out" ).arg( result.timed_out ) );
+
+    if( result.m == 0 )
+    {
+        return;
+    }
+
+    /*
+     *  Finding the windows may only grow linear with the number of windows
+     */
+    check( result.find_round_trips * result.n * 100 <=
+           base.find_round_trips * ( result.n + result.m ) * BENCH_SCALING_PERCENT,
+           label + QString( "find round trips %1, %2 with M = 0" ).arg( result.find_round_trips ).arg( base.find_round_trips ) );
+
+    /*
+     *  The unchanged properties are not read again
+     */
+    check( result.find_cached_round_trips < result.find_round_trips,
+           label + QString( "cached find round trips %1, uncached %2" ).arg( result.find_cached_round_trips ).arg( result.find_round_trips ) );
+
+    /*
+     *  The other operations only touch the Thunderbird windows
+     */
+    check( result.update_round_trips <= base.update_round_trips + BENCH_ROUND_TRIP_SLACK,
+           label + QString( "update positions round trips %1, %2 with M = 0" ).arg( result.update_round_trips ).arg( base.update_round_trips ) );
+    check( result.minimize_round_trips <= base.minimize_round_trips + BENCH_ROUND_TRIP_SLACK,
+           label + QString( "minimize round trips %1, %2 with M = 0" ).arg( result.minimize_round_trips ).arg( base.minimize_round_trips ) );
+    check( result.normalize_round_trips <= base.normalize_round_trips + BENCH_ROUND_TRIP_SLACK,
+           label + QString( "normalize round trips %1, %2 with M = 0" ).arg( result.normalize_round_trips ).arg( base.normalize_round_trips ) );
+}
+
+
+/*
+ *  Create the test windows and wait until they are managed
+ */
+void    WindowCtrlBenchmark::createWindows( int n, int m )
+{
+    for( int i = 0 ; i < n ; ++i )
+    {
+        m_windows.append( CreateTestWindow( m_display, m_win_ctrl->getPpid(), "3pane" ) );
+    }
+
+    for( int i = 0 ; i < m ; ++i )
+    {
+        m_windows.append( CreateTestWindow( m_display, QCoreApplication::applicationPid(), "other" ) );
+    }
+
+    SyncTestDisplay( m_display );
+
+    /*
+     *  Let the window manager reparent and map them before measuring
+     */
+    QElapsedTimer timer;
+    timer.start();
+
+    int managed = 0;
+    while( managed < m_windows.length() && timer.elapsed() < BENCH_MANAGE_TIMEOUT )
+    {
+        if( IsTestWindowManaged( m_display, m_windows.at( managed ) ) )
+        {
+            ++managed;
+        }
+        else
+        {
+            QCoreApplication::processEvents();
+            QThread::msleep( 10 );
+        }
+    }
+
+    if( managed < m_windows.length() )
+    {
+        fprintf( stderr, "Only %d of %d windows managed, is a window manager running?\n", managed, (int)m_windows.length() );
+    }
+
+    /*
+     *  Drop the events of the setup
+     */
+    QCoreApplication::processEvents();
+}
+
+
+/*
+ *  Destroy the test windows
+ */
+void    WindowCtrlBenchmark::destroyWindows()
+{
+    for( int i = 0 ; i < m_windows.length() ; ++i )
+    {
+        DestroyTestWindow( m_display, m_windows.at( i ) );
+    }
+
+    m_windows.clear();
+
+    SyncTestDisplay( m_display );
+    QCoreApplication::processEvents();
+}
+
+
+/*
+ *  Hide and show the windows, wait for the window manager each time
+ */
+void    WindowCtrlBenchmark::showHide()
+{
+    m_confirmed = true;
+    m_timed_out = 0;
+
+    m_win_ctrl->slotShowHide();
+    waitConfirmed();
+
+    m_win_ctrl->slotShowHide();
+    waitConfirmed();
+}
+
+
+/*
+ *  Wait for the window manager to confirm the last actions
+ */
+void    WindowCtrlBenchmark::waitConfirmed()
+{
+    if( !m_win_ctrl->isConfirmPending() )
+    {
+        return;
+    }
+
+    QEventLoop loop;
+    m_confirm_loop = &loop;
+
+    QTimer::singleShot( BENCH_CONFIRM_TIMEOUT, &loop, &QEventLoop::quit );
+    loop.exec();
+
+    m_confirm_loop = nullptr;
+
+    if( m_win_ctrl->isConfirmPending() )
+    {
+        m_confirmed = false;
+    }
+}
+
+
+/*
+ *  Handle the window manager confirmation
+ */
+void    WindowCtrlBenchmark::slotWindowsConfirmed( int confirmed, int timed_out )
+{
+    Q_UNUSED( confirmed )
+
+    m_timed_out += timed_out;
+
+    if( m_confirm_loop )
+    {
+        m_confirm_loop->quit();
+    }
+}
+
+
+/*
+ *  Get the round trips of an operation type since the last reset
+ */
+quint64 WindowCtrlBenchmark::roundTrips( WindowCtrlUnix::OperationType type ) const
+{
+    return m_win_ctrl->getOperationStats( type ).round_trips;
+}
+
+
+/*
+ *  Report a failed limit
+ */
+void    WindowCtrlBenchmark::check( bool ok, const QString& message )
+{
+    if( !ok )
+    {
+        fprintf( stderr, "FAIL %s\n", message.toLocal8Bit().constData() );
+
+        ++m_failures;
+    }
+}
@@ -0,0 +1,215 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*
+ *	Local includes
+ */
+#include "windowctrl.h"
+
+/*
+ *	Qt includes
+ */
+#include <QObject>
+#include <QList>
+#include <QMap>
+
+/*
+ *	Predefines
+ */
+class QEventLoop;
+
+/*
+ *  Time to wait for the window manager to manage the test windows (ms)
+ */
+#define BENCH_MANAGE_TIMEOUT    10000
+
+/*
+ *  Time to wait for the window manager to confirm a hide / show (ms)
+ */
+#define BENCH_CONFIRM_TIMEOUT   5000
+
+/*
+ *  Allowed growth of the find round trips per window, relative to M = 0 (%)
+ */
+#define BENCH_SCALING_PERCENT   150
+
+/*
+ *  Allowed extra round trips of the M independent operations, relative to M = 0
+ */
+#define BENCH_ROUND_TRIP_SLACK  2
+
+
+/**
+ * @brief The WindowCtrlBenchmark class. Window control scaling benchmark and regression check.
+ *
+ *  Creates N fake 3pane windows and M unrelated windows and measures the window control operations.
+ *  Needs an X server with an EWMH window manager, see run-benchmark.sh.
+ */
+class WindowCtrlBenchmark : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        /**
+         * @brief WindowCtrlBenchmark. Constructor, destructor.
+         *
+         *  @param parent   My parent.
+         */
+        explicit WindowCtrlBenchmark( QObject* parent = nullptr );
+        ~WindowCtrlBenchmark();
+
+        /**
+         * @brief run. Run the benchmark.
+         *
+         *  @return     0 if all limits are met, 1 if not, 2 if the benchmark could not run.
+         */
+        int run();
+
+    private slots:
+
+        /**
+         * @brief slotWindowsConfirmed. Handle the window manager confirmation.
+         *
+         *  @param confirmed    Number of confirmed windows.
+         *  @param timed_out    Number of windows that timed out.
+         */
+        void    slotWindowsConfirmed( int confirmed, int timed_out );
+
+    private:
+
+        /**
+         * @brief The Result class. The measurements of one N, M combination.
+         */
+        class Result
+        {
+            public:
+
+                int     n;
+                int     m;
+                int     found;
+                int     timed_out;
+                quint64 find_round_trips;
+                quint64 find_cached_round_trips;
+                quint64 update_round_trips;
+                quint64 minimize_round_trips;
+                quint64 normalize_round_trips;
+                qint64  find_time;
+                qint64  find_cached_time;
+                qint64  set_time;
+                qint64  update_time;
+                qint64  show_hide_time;
+        };
+
+        /**
+         * @brief measure. Measure one N, M combination.
+         *
+         *  @param n    Number of 3pane windows.
+         *  @param m    Number of unrelated windows.
+         *
+         *  @return     The measurements.
+         */
+        Result  measure( int n, int m );
+
+        /**
+         * @brief verify. Check the measurements against the limits.
+         *
+         *  @param result   The measurements.
+         *  @param base     The measurements with the same N and M = 0.
+         */
+        void    verify( const Result& result, const Result& base );
+
+        /**
+         * @brief createWindows. Create the test windows and wait until they are managed.
+         *
+         *  @param n    Number of 3pane windows.
+         *  @param m    Number of unrelated windows.
+         */
+        void    createWindows( int n, int m );
+
+        /**
+         * @brief destroyWindows. Destroy the test windows.
+         */
+        void    destroyWindows();
+
+        /**
+         * @brief showHide. Hide and show the windows, wait for the window manager each time.
+         */
+        void    showHide();
+
+        /**
+         * @brief waitConfirmed. Wait for the window manager to confirm the last actions.
+         */
+        void    waitConfirmed();
+
+        /**
+         * @brief roundTrips. Get the round trips of an operation type since the last reset.
+         *
+         *  @param type     The operation type.
+         *
+         *  @return     The round trips.
+         */
+        quint64 roundTrips( WindowCtrlUnix::OperationType type ) const;
+
+        /**
+         * @brief check. Report a failed limit.
+         *
+         *  @param ok       The limit is met.
+         *  @param message  The failure message.
+         */
+        void    check( bool ok, const QString& message );
+
+    private:
+
+        /**
+         * @brief m_n_3pane. The numbers of 3pane windows.
+         */
+        const QList< int > m_n_3pane = { 1, 2, 4, 8 };
+
+        /**
+         * @brief m_n_other. The numbers of unrelated windows.
+         */
+        const QList< int > m_n_other = { 0, 100, 1000 };
+
+        /**
+         * @brief m_preferences. The preferences.
+         */
+        Preferences*    m_preferences;
+
+        /**
+         * @brief m_win_ctrl. The window control under test.
+         */
+        WindowCtrl*     m_win_ctrl;
+
+        /**
+         * @brief m_display. Connection for the test windows.
+         */
+        void*   m_display;
+
+        /**
+         * @brief m_windows. The test windows.
+         */
+        QList< quint64 >    m_windows;
+
+        /**
+         * @brief m_confirm_loop. The loop waiting for the confirmation.
+         */
+        QEventLoop* m_confirm_loop;
+
+        /**
+         * @brief m_confirmed. The last actions have been confirmed.
+         */
+        bool    m_confirmed;
+
+        /**
+         * @brief m_timed_out. Number of windows that timed out.
+         */
+        int     m_timed_out;
+
+        /**
+         * @brief m_failures. Number of failed limits.
+         */
+        int     m_failures;
+};
+
+#endif // BENCHMARK_H
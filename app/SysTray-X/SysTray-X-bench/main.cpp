@@ -0,0 +1,18 @@
+/*
+ *	Local includes
+ */
+#include "benchmark.h"
+
+/*
+ *	Qt includes
+ */
+#include <QApplication>
+
+int main( int argc, char *argv[] )
+{
+    QApplication a( argc, argv );
+
+    WindowCtrlBenchmark benchmark;
+
+    return benchmark.run();
+}
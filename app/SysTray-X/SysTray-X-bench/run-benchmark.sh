@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+#   Run the window control benchmark on a virtual display with a lightweight EWMH window manager.
+#   Fails when a scaling limit is exceeded.
+#
+#   Usage: run-benchmark.sh [path to SysTray-X-bench]
+#
+
+BENCH="${1:-$(dirname "$0")/SysTray-X-bench}"
+DISPLAY_NUMBER=":${BENCH_DISPLAY:-99}"
+
+for tool in Xvfb openbox ; do
+    if ! command -v $tool > /dev/null ; then
+        echo "$tool not found" >&2
+        exit 2
+    fi
+done
+
+Xvfb $DISPLAY_NUMBER -screen 0 1920x1080x24 -nolisten tcp > /dev/null 2>&1 &
+XVFB_PID=$!
+
+WM_PID=""
+cleanup() {
+    [ -n "$WM_PID" ] && kill $WM_PID 2> /dev/null
+    kill $XVFB_PID 2> /dev/null
+}
+trap cleanup EXIT
+
+export DISPLAY=$DISPLAY_NUMBER
+
+#
+#   Wait for the server
+#
+for i in $(seq 50) ; do
+    xdpyinfo > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+openbox --sm-disable > /dev/null 2>&1 &
+WM_PID=$!
+
+#
+#   Wait for the window manager
+#
+for i in $(seq 50) ; do
+    xprop -root _NET_SUPPORTING_WM_CHECK 2> /dev/null | grep -q "window id" && break
+    sleep 0.1
+done
+
+"$BENCH"
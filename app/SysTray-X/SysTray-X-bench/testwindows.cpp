@@ -0,0 +1,105 @@
+#include "testwindows.h"
+
+/*
+ *  System includes
+ */
+#include <string.h>
+
+/*
+ *  X11 includes
+ */
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+
+/*
+ *  Open a separate connection for the test windows
+ */
+void*   OpenTestDisplay()
+{
+    return XOpenDisplay( NULL );
+}
+
+
+/*
+ *  Close the test window connection
+ */
+void    CloseTestDisplay( void* display )
+{
+    XCloseDisplay( (Display*)display );
+}
+
+
+/*
+ *  Wait until the server processed all requests
+ */
+void    SyncTestDisplay( void* display )
+{
+    XSync( (Display*)display, False );
+}
+
+
+/*
+ *  Create and map a window carrying a pid and role
+ */
+quint64 CreateTestWindow( void* display, long pid, const char* role )
+{
+    Display* dsp = (Display*)display;
+
+    Window window = XCreateSimpleWindow( dsp, XDefaultRootWindow( dsp ), 0, 0, 200, 100, 0, 0, 0 );
+
+    /*
+     *  Set the properties used to find the Thunderbird windows
+     */
+    Atom pid_atom = XInternAtom( dsp, "_NET_WM_PID", False );
+    XChangeProperty( dsp, window, pid_atom, XA_CARDINAL, 32, PropModeReplace,
+                     reinterpret_cast<unsigned char*>( &pid ), 1 );
+
+    Atom role_atom = XInternAtom( dsp, "WM_WINDOW_ROLE", False );
+    XChangeProperty( dsp, window, role_atom, XA_STRING, 8, PropModeReplace,
+                     reinterpret_cast<const unsigned char*>( role ), strlen( role ) + 1 );
+
+    XMapWindow( dsp, window );
+
+    return window;
+}
+
+
+/*
+ *  Destroy a test window
+ */
+void    DestroyTestWindow( void* display, quint64 window )
+{
+    XDestroyWindow( (Display*)display, window );
+}
+
+
+/*
+ *  Has the window manager set the WM_STATE of a window
+ */
+bool    IsTestWindowManaged( void* display, quint64 window )
+{
+    Display* dsp = (Display*)display;
+
+    Atom wm_state_atom = XInternAtom( dsp, "WM_STATE", False );
+
+    Atom type;
+    int format;
+    unsigned long len;
+    unsigned long remain;
+    unsigned char* list = NULL;
+
+    bool managed = false;
+    if( XGetWindowProperty( dsp, window, wm_state_atom, 0, 2, False, AnyPropertyType,
+                &type, &format, &len, &remain, &list ) == Success && type != None )
+    {
+        managed = len > 0;
+    }
+
+    if( list )
+    {
+        XFree( list );
+    }
+
+    return managed;
+}
@@ -0,0 +1,63 @@
+#ifndef TESTWINDOWS_H
+#define TESTWINDOWS_H
+
+/*
+ *	Qt includes
+ */
+#include <QtGlobal>
+
+/*
+ *  The X11 headers stay out of the Qt code, as in SysTray-X-lib-x11
+ */
+
+/**
+ * @brief OpenTestDisplay. Open a separate connection for the test windows.
+ *
+ *  @return     The display, NULL on failure.
+ */
+void*   OpenTestDisplay();
+
+/**
+ * @brief CloseTestDisplay. Close the test window connection.
+ *
+ *  @param display  The display.
+ */
+void    CloseTestDisplay( void* display );
+
+/**
+ * @brief SyncTestDisplay. Wait until the server processed all requests.
+ *
+ *  @param display  The display.
+ */
+void    SyncTestDisplay( void* display );
+
+/**
+ * @brief CreateTestWindow. Create and map a window carrying a pid and role.
+ *
+ *  @param display  The display.
+ *  @param pid      The _NET_WM_PID value.
+ *  @param role     The WM_WINDOW_ROLE value.
+ *
+ *  @return     The window.
+ */
+quint64 CreateTestWindow( void* display, long pid, const char* role );
+
+/**
+ * @brief DestroyTestWindow. Destroy a test window.
+ *
+ *  @param display  The display.
+ *  @param window   The window.
+ */
+void    DestroyTestWindow( void* display, quint64 window );
+
+/**
+ * @brief IsTestWindowManaged. Has the window manager set the WM_STATE of a window.
+ *
+ *  @param display  The display.
+ *  @param window   The window.
+ *
+ *  @return     True if managed.
+ */
+bool    IsTestWindowManaged( void* display, quint64 window );
+
+#endif // TESTWINDOWS_H
@@ -5,7 +5,9 @@
  */
 #include <stdio.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 /*
  *  X11 includes
@@ -20,6 +22,88 @@
  * */
 bool    x11Error = false;
 
+/*
+ *  X11 error buffer, for the errors of one display
+ */
+Display*        x11ErrorsDisplay = NULL;
+X11Error        x11Errors[ X11_ERROR_BUFFER ];
+int             x11ErrorsFirst = 0;
+int             x11ErrorsCount = 0;
+pthread_mutex_t x11ErrorsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ *  Round trip counters, kept with the display as Xlib extension data
+ */
+#define X11_COUNTERS_EXTENSION  0x53595358
+
+typedef struct {
+    unsigned long round_trips;  /* requests that waited for a reply */
+    unsigned long request;      /* serial before the current reply-bearing call */
+} DisplayCounters;
+
+
+/*
+ *  Get the counters of a display
+ */
+static DisplayCounters* GetDisplayCounters( Display* display )
+{
+    XEDataObject object;
+    object.display = display;
+
+    XExtData** list = XEHeadOfExtensionList( object );
+    XExtData* data = XFindOnExtensionList( list, X11_COUNTERS_EXTENSION );
+    if( data == NULL )
+    {
+        /*
+         *  Freed by XCloseDisplay
+         */
+        data = (XExtData*)calloc( 1, sizeof( XExtData ) );
+        data->number = X11_COUNTERS_EXTENSION;
+        data->private_data = (XPointer)calloc( 1, sizeof( DisplayCounters ) );
+
+        XAddToExtensionList( list, data );
+    }
+
+    return (DisplayCounters*)data->private_data;
+}
+
+
+/*
+ *  Mark the start of a reply-bearing call
+ */
+static void BeginReplies( Display* display )
+{
+    GetDisplayCounters( display )->request = XNextRequest( display );
+}
+
+
+/*
+ *  Count the requests sent by a reply-bearing call, Xlib waits for each of their replies
+ */
+template< typename T >
+static T    CountReplies( Display* display, T result )
+{
+    DisplayCounters* counters = GetDisplayCounters( display );
+    counters->round_trips += XNextRequest( display ) - counters->request;
+
+    return result;
+}
+
+
+/*
+ *  Make an Xlib call waiting for replies and count its round trips
+ */
+#define X11_REPLY( display, call )  ( BeginReplies( display ), CountReplies( display, call ) )
+
+
+/*
+ *  Intern an atom, no round trip if cached by Xlib
+ */
+static Atom InternAtom( Display* display, const char* name, Bool only_if_exists )
+{
+    return X11_REPLY( display, XInternAtom( display, name, only_if_exists ) );
+}
+
 
 /*
  *  Open the display
@@ -55,8 +139,11 @@ int GetDefaultScreen( void* display  )
  */
 int GetScreenNumberOfScreen( void* display, quint64 window )
 {
+    Display* dsp = (Display*)display;
+
     XWindowAttributes xwa;
-    XGetWindowAttributes( (Display*)display, window, &xwa );
+    X11_REPLY( dsp, XGetWindowAttributes( dsp, window, &xwa ) );
+
     return XScreenNumberOfScreen( xwa.screen );
 }
 
@@ -84,7 +171,9 @@ void    Flush( void* display )
  */
 void    Sync( void* display )
 {
-    XSync( (Display*)display, False );
+    Display* dsp = (Display*)display;
+
+    X11_REPLY( dsp, XSync( dsp, False ) );
 }
 
 
@@ -98,7 +187,9 @@ int QueryTree( void* display, quint64 window, quint64* root, quint64* parent, vo
     Window* x11_children;
     unsigned int x11_childrenCount;
 
-    int status = XQueryTree( (Display*)display, window, &x11_root, &x11_parent, &x11_children, &x11_childrenCount );
+    Display* dsp = (Display*)display;
+
+    int status = X11_REPLY( dsp, XQueryTree( dsp, window, &x11_root, &x11_parent, &x11_children, &x11_childrenCount ) );
 
     *root = x11_root;
     *parent = x11_parent;
@@ -114,7 +205,9 @@ int QueryTree( void* display, quint64 window, quint64* root, quint64* parent, vo
  */
 int FetchName( void* display, quint64 window, char** name )
 {
-    return XFetchName( (Display*)display, window, name );
+    Display* dsp = (Display*)display;
+
+    return X11_REPLY( dsp, XFetchName( dsp, window, name ) );
 }
 
 
@@ -150,9 +243,11 @@ void    MapWindow( void* display, quint64 window )
  */
 void    GetWMNormalHints( void* display, quint64 window, SizeHints* hints )
 {
+    Display* dsp = (Display*)display;
+
     XSizeHints size_hint;
     long dummy;
-    XGetWMNormalHints( (Display*)display, window, &size_hint, &dummy);
+    X11_REPLY( dsp, XGetWMNormalHints( dsp, window, &size_hint, &dummy ) );
 
     hints->flags = size_hint.flags;
     hints->x = size_hint.x;
@@ -228,7 +323,41 @@ void    SetInputFocus( void* display, quint64 window )
  */
 char*   GetAtomName( void* display, long atom )
 {
-    return XGetAtomName( (Display*)display, atom );
+    Display* dsp = (Display*)display;
+
+    return X11_REPLY( dsp, XGetAtomName( dsp, atom ) );
+}
+
+
+/*
+ *  Get the atoms of a list of names
+ */
+int     InternAtoms( void* display, const char** names, int count, long* atoms )
+{
+    Display* dsp = (Display*)display;
+
+    Atom* x11_atoms = new Atom[ count ];
+
+    /*
+     *  The requests for the uncached atoms are sent in one go, one round trip
+     */
+    unsigned long request = XNextRequest( dsp );
+
+    int status = XInternAtoms( dsp, (char**)names, count, False, x11_atoms );
+
+    if( XNextRequest( dsp ) != request )
+    {
+        ++GetDisplayCounters( dsp )->round_trips;
+    }
+
+    for( int i = 0 ; i < count ; ++i )
+    {
+        atoms[ i ] = status ? (long)x11_atoms[ i ] : 0;
+    }
+
+    delete [] x11_atoms;
+
+    return status;
 }
 
 
@@ -239,8 +368,8 @@ void    ChangeWindowTypeProperty( void* display, quint64 window, const char* win
 {
     Display* dsp = (Display*)display;
 
-    Atom prop = XInternAtom( dsp, "_NET_WM_WINDOW_TYPE", True );
-    Atom atom_win_type = XInternAtom( dsp, win_type, True );
+    Atom prop = InternAtom( dsp, "_NET_WM_WINDOW_TYPE", True );
+    Atom atom_win_type = InternAtom( dsp, win_type, True );
 
     Atom type;
     int format;
@@ -248,8 +377,8 @@ void    ChangeWindowTypeProperty( void* display, quint64 window, const char* win
     unsigned long len;
     unsigned char* list = NULL;
 
-    if( XGetWindowProperty( dsp, window, prop, 0, LONG_MAX, False, AnyPropertyType,
-                &type, &format, &len, &remain, &list ) == Success && len && list )
+    if( X11_REPLY( dsp, XGetWindowProperty( dsp, window, prop, 0, LONG_MAX, False, AnyPropertyType,
+                &type, &format, &len, &remain, &list ) ) == Success && len && list )
     {
         XFree( list );
 
@@ -276,7 +405,7 @@ void*   GetWindowProperty( void* display, quint64 window, const char* atom, qint
         win = window;
     }
 
-    Atom prop = XInternAtom( (Display*)display, atom, False );
+    Atom prop = InternAtom( dsp, atom, False );
 
     Atom type;
     int format;
@@ -284,8 +413,8 @@ void*   GetWindowProperty( void* display, quint64 window, const char* atom, qint
     unsigned long len;
     unsigned char* list = NULL;
 
-    if( XGetWindowProperty( dsp, win, prop, 0, LONG_MAX, False, AnyPropertyType,
-                &type, &format, &len, &remain, &list ) == Success )
+    if( X11_REPLY( dsp, XGetWindowProperty( dsp, win, prop, 0, LONG_MAX, False, AnyPropertyType,
+                &type, &format, &len, &remain, &list ) ) == Success )
     {
         if( nlist != NULL )
         {
@@ -318,11 +447,11 @@ void    SendEvent( void* display, quint64 window, const char* msg_type,
     Atom msg_atom;
     if( strcmp( msg_type, "WM_PROTOCOLS" ) == 0 )
     {
-        msg_atom = XInternAtom( dsp, msg_type, True );
+        msg_atom = InternAtom( dsp, msg_type, True );
     }
     else
     {
-        msg_atom = XInternAtom( dsp, msg_type, False );
+        msg_atom = InternAtom( dsp, msg_type, False );
     }
 
     XEvent event;
@@ -342,32 +471,32 @@ void    SendEvent( void* display, quint64 window, const char* msg_type,
         {
             case _ATOM_SKIP_TASKBAR:
             {
-                event.xclient.data.l[1] = XInternAtom( dsp, "_NET_WM_STATE_SKIP_TASKBAR", False );
+                event.xclient.data.l[1] = InternAtom( dsp, "_NET_WM_STATE_SKIP_TASKBAR", False );
                 break;
             }
 
             case _ATOM_SKIP_PAGER:
             {
-                event.xclient.data.l[1] = XInternAtom( dsp, "_NET_WM_STATE_SKIP_PAGER", False );
+                event.xclient.data.l[1] = InternAtom( dsp, "_NET_WM_STATE_SKIP_PAGER", False );
                 break;
             }
 
             case _ATOM_MAXIMIZED_VERT:
             {
-                event.xclient.data.l[1] = XInternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_VERT", False );
+                event.xclient.data.l[1] = InternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_VERT", False );
                 break;
             }
 
             case _ATOM_MAXIMIZED_HORZ:
             {
-                event.xclient.data.l[1] = XInternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_HORZ", False );
+                event.xclient.data.l[1] = InternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_HORZ", False );
                 break;
             }
 
             case _ATOM_MAXIMIZED:
             {
-                event.xclient.data.l[1] = XInternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_VERT", False );
-                event.xclient.data.l[2] = XInternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_HORZ", False );
+                event.xclient.data.l[1] = InternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_VERT", False );
+                event.xclient.data.l[2] = InternAtom( dsp, "_NET_WM_STATE_MAXIMIZED_HORZ", False );
                 break;
             }
 
@@ -384,7 +513,7 @@ void    SendEvent( void* display, quint64 window, const char* msg_type,
         {
             case _ATOM_DELETE_WINDOW:
             {
-                event.xclient.data.l[0] = XInternAtom( dsp, "WM_DELETE_WINDOW", False );
+                event.xclient.data.l[0] = InternAtom( dsp, "WM_DELETE_WINDOW", False );
                 break;
             }
 
@@ -418,7 +547,7 @@ void    GetWindowFrameExtensions( void *display, quint64 window, int* left, int*
     Display* dsp = (Display*)display;
 
     char prop_name[] = "_NET_FRAME_EXTENTS";
-    Atom prop = XInternAtom( dsp, prop_name, True );
+    Atom prop = InternAtom( dsp, prop_name, True );
 
     /*
      *  Reset the margins
@@ -437,8 +566,8 @@ void    GetWindowFrameExtensions( void *display, quint64 window, int* left, int*
     unsigned long len;
     unsigned char* list = NULL;
 
-    if( XGetWindowProperty( dsp, window, prop, 0, 4, False, AnyPropertyType,
-                &type, &format, &len, &remain, &list ) == Success )
+    if( X11_REPLY( dsp, XGetWindowProperty( dsp, window, prop, 0, 4, False, AnyPropertyType,
+                &type, &format, &len, &remain, &list ) ) == Success )
     {
         if( list && len == 4 )
         {
@@ -470,7 +599,7 @@ void    GetWindowPosition( void* display, quint64 window, int* pos_x, int* pos_y
     int x1, y1;
     Window child;
     XWindowAttributes xwa;
-    XTranslateCoordinates( dsp, window, XDefaultRootWindow( dsp ), 0, 0, &x1, &y1, &child );
+    X11_REPLY( dsp, XTranslateCoordinates( dsp, window, XDefaultRootWindow( dsp ), 0, 0, &x1, &y1, &child ) );
 
     /*
      *  Get position, method 2
@@ -480,7 +609,7 @@ void    GetWindowPosition( void* display, quint64 window, int* pos_x, int* pos_y
     uint width, height;
     uint border;
     uint depth;
-    XGetGeometry( dsp, window, &root, &x2, &y2, &width, &height, &border, &depth );
+    X11_REPLY( dsp, XGetGeometry( dsp, window, &root, &x2, &y2, &width, &height, &border, &depth ) );
 
     int x = x1;
     int y = y1;
@@ -494,13 +623,31 @@ void    GetWindowPosition( void* display, quint64 window, int* pos_x, int* pos_y
     /*
      *  Correct the position
      */
-    XGetWindowAttributes( dsp, window, &xwa );
+    X11_REPLY( dsp, XGetWindowAttributes( dsp, window, &xwa ) );
 
     *pos_x = x - xwa.x;
     *pos_y = y - xwa.y;
 }
 
 
+/*
+ *  Get the window origin
+ */
+void    GetWindowOrigin( void* display, quint64 window, int* root_x, int* root_y, int* parent_x, int* parent_y )
+{
+    Display* dsp = (Display*)display;
+
+    Window child;
+    X11_REPLY( dsp, XTranslateCoordinates( dsp, window, XDefaultRootWindow( dsp ), 0, 0, root_x, root_y, &child ) );
+
+    XWindowAttributes xwa;
+    X11_REPLY( dsp, XGetWindowAttributes( dsp, window, &xwa ) );
+
+    *parent_x = xwa.x;
+    *parent_y = xwa.y;
+}
+
+
 /*
  *  Get the window rect
  */
@@ -523,8 +670,8 @@ void    GetWindowRectangle( void* display, quint64 window, int* win_x, int* win_
     int x, y;
     Window child;
     XWindowAttributes xwa;
-    XTranslateCoordinates( dsp, window, XDefaultRootWindow( dsp ), 0, 0, &x, &y, &child );
-    XGetWindowAttributes( dsp, window, &xwa );
+    X11_REPLY( dsp, XTranslateCoordinates( dsp, window, XDefaultRootWindow( dsp ), 0, 0, &x, &y, &child ) );
+    X11_REPLY( dsp, XGetWindowAttributes( dsp, window, &xwa ) );
 
     *win_x = x - xwa.x - left;
     *win_y = y - xwa.y - top;
@@ -541,27 +688,254 @@ void    MoveWindow( void* display, quint64 window, int x, int y )
 }
 
 
+/*
+ *  Select the events of a window
+ */
+void    SelectInput( void* display, quint64 window, long mask )
+{
+    XSelectInput( (Display*)display, window, mask );
+}
+
+
+/*
+ *  Get the connection file descriptor
+ */
+int     GetConnectionNumber( void* display )
+{
+    return XConnectionNumber( (Display*)display );
+}
+
+
+/*
+ *  Get the number of pending events
+ */
+int     EventsPending( void* display )
+{
+    return XPending( (Display*)display );
+}
+
+
+/*
+ *  Get the number of events already read into the queue
+ */
+int     EventsQueued( void* display )
+{
+    return XEventsQueued( (Display*)display, QueuedAlready );
+}
+
+
+/*
+ *  Get the next event
+ */
+void    NextEvent( void* display, WindowEvent* event )
+{
+    XEvent x11_event;
+    XNextEvent( (Display*)display, &x11_event );
+
+    memset( event, 0, sizeof( WindowEvent ) );
+
+    switch( x11_event.type )
+    {
+        case PropertyNotify:
+        {
+            event->type = _EVENT_PROPERTY_NOTIFY;
+            event->window = x11_event.xproperty.window;
+            event->atom = x11_event.xproperty.atom;
+            break;
+        }
+
+        case ConfigureNotify:
+        {
+            event->type = _EVENT_CONFIGURE_NOTIFY;
+            event->window = x11_event.xconfigure.window;
+            event->x = x11_event.xconfigure.x;
+            event->y = x11_event.xconfigure.y;
+            event->width = x11_event.xconfigure.width;
+            event->height = x11_event.xconfigure.height;
+            event->send_event = x11_event.xconfigure.send_event;
+            break;
+        }
+
+        case DestroyNotify:
+        {
+            event->type = _EVENT_DESTROY_NOTIFY;
+            event->window = x11_event.xdestroywindow.window;
+            break;
+        }
+
+        case ReparentNotify:
+        {
+            event->type = _EVENT_REPARENT_NOTIFY;
+            event->window = x11_event.xreparent.window;
+            break;
+        }
+
+        default:
+        {
+            event->type = _EVENT_OTHER;
+            event->window = x11_event.xany.window;
+            break;
+        }
+    }
+}
+
+
+/*
+ *  Get a window property by atom
+ */
+void*   GetWindowPropertyAtom( void* display, quint64 window, long atom, int* format, qint32* nlist )
+{
+    Display* dsp = (Display*)display;
+
+    Atom type;
+    unsigned long remain;
+    unsigned long len;
+    unsigned char* list = NULL;
+
+    if( X11_REPLY( dsp, XGetWindowProperty( dsp, window, atom, 0, LONG_MAX, False, AnyPropertyType,
+                &type, format, &len, &remain, &list ) ) == Success && type != None )
+    {
+        *nlist = (qint32)len;
+
+        return list;
+    }
+
+    *nlist = (qint32)-1;
+
+    if( list )
+    {
+        XFree( list );
+    }
+
+    return NULL;
+}
+
+
+/*
+ *  Get the number of requests sent
+ */
+unsigned long   GetRequestCount( void* display )
+{
+    return XNextRequest( (Display*)display ) - 1;
+}
+
+
+/*
+ *  Get the number of round trips
+ */
+unsigned long   GetRoundTripCount( void* display )
+{
+    return GetDisplayCounters( (Display*)display )->round_trips;
+}
+
+
 /*
  *  The error handler
  */
 int ErrorHandler( Display* display, XErrorEvent* event )
 {
-    fprintf( stderr, "Error code: %x\n", event->error_code );
+    pthread_mutex_lock( &x11ErrorsLock );
 
-    char buf[ 1024 ];
-    XGetErrorText( display, event->error_code, buf, 1024 );
-    fprintf( stderr, "%s\n", buf );
+    if( display != x11ErrorsDisplay )
+    {
+        pthread_mutex_unlock( &x11ErrorsLock );
+
+        /*
+         *  Not ours to attribute
+         */
+        fprintf( stderr, "Error code: %x\n", event->error_code );
+
+        char buf[ 1024 ];
+        XGetErrorText( display, event->error_code, buf, 1024 );
+        fprintf( stderr, "%s\n", buf );
+
+        return 0;
+    }
+
+    /*
+     *  Store the error, overwrite the oldest when full
+     */
+    int index = ( x11ErrorsFirst + x11ErrorsCount ) % X11_ERROR_BUFFER;
+    if( x11ErrorsCount == X11_ERROR_BUFFER )
+    {
+        x11ErrorsFirst = ( x11ErrorsFirst + 1 ) % X11_ERROR_BUFFER;
+    }
+    else
+    {
+        ++x11ErrorsCount;
+    }
+
+    x11Errors[ index ].serial = event->serial;
+    x11Errors[ index ].error_code = event->error_code;
+    x11Errors[ index ].request_code = event->request_code;
+    x11Errors[ index ].resource = event->resourceid;
 
     x11Error = true;
+
+    pthread_mutex_unlock( &x11ErrorsLock );
+
     return 0;
 }
 
 
+/*
+ *  Get the serial of the next request
+ */
+unsigned long   GetNextRequestSerial( void* display )
+{
+    return XNextRequest( (Display*)display );
+}
+
+
+/*
+ *  Get the serial of the last processed request
+ */
+unsigned long   GetLastProcessedSerial( void* display )
+{
+    return XLastKnownRequestProcessed( (Display*)display );
+}
+
+
+/*
+ *  Get and clear the recorded errors
+ */
+int     TakeErrors( X11Error* errors )
+{
+    pthread_mutex_lock( &x11ErrorsLock );
+
+    int count = x11ErrorsCount;
+    for( int i = 0 ; i < count ; ++i )
+    {
+        errors[ i ] = x11Errors[ ( x11ErrorsFirst + i ) % X11_ERROR_BUFFER ];
+    }
+
+    x11ErrorsFirst = 0;
+    x11ErrorsCount = 0;
+
+    pthread_mutex_unlock( &x11ErrorsLock );
+
+    return count;
+}
+
+
+/*
+ *  Get the description of an error code
+ */
+void    GetErrorText( void* display, int error_code, char* buffer, int length )
+{
+    XGetErrorText( (Display*)display, error_code, buffer, length );
+}
+
+
 /*
  *  Set the error handler
  */
-void    SetErrorHandler()
+void    SetErrorHandler( void* display )
 {
+    pthread_mutex_lock( &x11ErrorsLock );
+    x11ErrorsDisplay = (Display*)display;
+    pthread_mutex_unlock( &x11ErrorsLock );
+
     XSetErrorHandler( ErrorHandler );
 }
 
@@ -583,7 +957,12 @@ bool    Error()
  */
 void    UnSetErrorHandler()
 {
+    pthread_mutex_lock( &x11ErrorsLock );
     x11Error = false;
+    x11ErrorsDisplay = NULL;
+    x11ErrorsFirst = 0;
+    x11ErrorsCount = 0;
+    pthread_mutex_unlock( &x11ErrorsLock );
 
     XSetErrorHandler( NULL );
 }
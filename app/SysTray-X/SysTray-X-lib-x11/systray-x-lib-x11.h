@@ -50,6 +50,54 @@ enum ProtocolAtoms
     _ATOM_DELETE_WINDOW = 0
 };
 
+/*
+ *  Event masks
+ */
+enum EventMasks
+{
+    _STRUCTURE_NOTIFY_MASK = ( 1L << 17 ),
+    _PROPERTY_CHANGE_MASK = ( 1L << 22 )
+};
+
+/*
+ *  Event types
+ */
+enum EventTypes
+{
+    _EVENT_OTHER = 0,
+    _EVENT_PROPERTY_NOTIFY,
+    _EVENT_CONFIGURE_NOTIFY,
+    _EVENT_DESTROY_NOTIFY,
+    _EVENT_REPARENT_NOTIFY
+};
+
+/*
+ *  Window event
+ */
+typedef struct {
+    int type;           /* one of EventTypes */
+    quint64 window;     /* the window the event is about */
+    long atom;          /* property notify: the property */
+    int x, y;           /* configure notify: the position */
+    int width, height;  /* configure notify: the size */
+    bool send_event;    /* configure notify: synthetic event from the window manager */
+} WindowEvent;
+
+/*
+ *  X11 error, attributed by the request serial
+ */
+typedef struct {
+    unsigned long serial;   /* serial of the failed request */
+    int error_code;         /* the X11 error code */
+    int request_code;       /* major opcode of the failed request */
+    quint64 resource;       /* the resource (window, atom) of the failed request */
+} X11Error;
+
+/*
+ *  Size of the error buffer
+ */
+#define X11_ERROR_BUFFER    64
+
 struct Point {
     long x;
     long y;
@@ -196,6 +244,18 @@ void    SetInputFocus( void* display, quint64 window );
  */
 char*   GetAtomName( void* display, long atom );
 
+/**
+ * @brief InternAtoms. Get the atoms for a list of names in one request.
+ *
+ *  @param display  The display
+ *  @param names    The atom names
+ *  @param count    The number of names
+ *  @param atoms    Storage for the atoms
+ *
+ *  @return     The status.
+ */
+int     InternAtoms( void* display, const char** names, int count, long* atoms );
+
 /**
  * @brief ChangeWindowTypeProperty. Change the window typw property.
  *
@@ -253,6 +313,18 @@ void    GetWindowFrameExtensions( void *display, quint64 window, int* left, int*
  */
 void    GetWindowPosition( void *display, quint64 window, int* pos_x, int* pos_y );
 
+/**
+ * @brief GetWindowOrigin. Get the window origin on the root and in its parent.
+ *
+ *  @param display  The display
+ *  @param window   The window
+ *  @param root_x   Pointer to the x position on the root.
+ *  @param root_y   Pointer to the y position on the root.
+ *  @param parent_x Pointer to the x position in the parent.
+ *  @param parent_y Pointer to the y position in the parent.
+ */
+void    GetWindowOrigin( void* display, quint64 window, int* root_x, int* root_y, int* parent_x, int* parent_y );
+
 /**
  * @brief GetWindowRectangle. Get the window rectangle.
  *
@@ -275,10 +347,124 @@ void    GetWindowRectangle( void* display, quint64 window, int* win_x, int* win_
  */
 void    MoveWindow( void* display, quint64 window, int x, int y );
 
+/**
+ * @brief SelectInput. Select the events to receive for a window.
+ *
+ *  @param display  The display
+ *  @param window   The window
+ *  @param mask     The EventMasks
+ */
+void    SelectInput( void* display, quint64 window, long mask );
+
+/**
+ * @brief GetConnectionNumber. Get the file descriptor of the display connection.
+ *
+ *  @param display  The display
+ *
+ *  @return     The file descriptor.
+ */
+int     GetConnectionNumber( void* display );
+
+/**
+ * @brief EventsPending. Get the number of events ready to be read, does not block.
+ *
+ *  @param display  The display
+ *
+ *  @return     The number of events.
+ */
+int     EventsPending( void* display );
+
+/**
+ * @brief EventsQueued. Get the number of events already read into the queue, no I/O.
+ *
+ *  @param display  The display
+ *
+ *  @return     The number of events.
+ */
+int     EventsQueued( void* display );
+
+/**
+ * @brief NextEvent. Get the next event, blocks if none is pending.
+ *
+ *  @param display  The display
+ *  @param event    The event
+ */
+void    NextEvent( void* display, WindowEvent* event );
+
+/**
+ * @brief GetWindowPropertyAtom. Get a window property by atom.
+ *
+ *  @param display  The display
+ *  @param window   The window
+ *  @param atom     The property atom
+ *  @param format   The property format (8, 16 or 32)
+ *  @param nlist    The number of items
+ *
+ *  @return     Pointer to the data or NULL, free with Free(). Format 32 items are longs.
+ */
+void*   GetWindowPropertyAtom( void* display, quint64 window, long atom, int* format, qint32* nlist );
+
+/**
+ * @brief GetRequestCount. Get the number of requests sent to the server.
+ *
+ *  @param display  The display
+ *
+ *  @return     The number of requests.
+ */
+unsigned long   GetRequestCount( void* display );
+
+/**
+ * @brief GetRoundTripCount. Get the number of requests that waited for a reply.
+ *
+ *  @param display  The display
+ *
+ *  @return     The number of round trips.
+ */
+unsigned long   GetRoundTripCount( void* display );
+
+/**
+ * @brief GetNextRequestSerial. Get the serial of the next request.
+ *
+ *  @param display  The display
+ *
+ *  @return     The serial.
+ */
+unsigned long   GetNextRequestSerial( void* display );
+
+/**
+ * @brief GetLastProcessedSerial. Get the serial of the last request known to be processed by the server.
+ *
+ *  @param display  The display
+ *
+ *  @return     The serial.
+ */
+unsigned long   GetLastProcessedSerial( void* display );
+
+/**
+ * @brief TakeErrors. Get and clear the recorded errors, oldest first.
+ *
+ *  @param errors   The errors, at least X11_ERROR_BUFFER entries
+ *
+ *  @return     The number of errors, older errors are lost when the buffer overflows.
+ */
+int     TakeErrors( X11Error* errors );
+
+/**
+ * @brief GetErrorText. Get the description of an error code.
+ *
+ *  @param display      The display
+ *  @param error_code   The error code
+ *  @param buffer       The text buffer
+ *  @param length       The length of the buffer
+ */
+void    GetErrorText( void* display, int error_code, char* buffer, int length );
+
 /**
  * @brief SetErrorHandler. Set the x11 error handler.
+ *
+ *  @param display  The display whose errors are recorded for TakeErrors, others go to stderr
  */
-void    SetErrorHandler();
+void    SetErrorHandler( void* display );
 
 /**
  * @brief Error. Get the error state.
@@ -14,3 +14,10 @@ SUBDIRS +=  SysTray-X-lib-x11
 }
 #SUBDIRS +=  SysTray-X-lib-win
 SUBDIRS +=  SysTray-X-app
+
+#
+#	The window control benchmark, qmake CONFIG+=benchmark
+#
+unix:benchmark: {
+SUBDIRS +=  SysTray-X-bench
+}
@@ -43,50 +43,30 @@ SysTrayX.Messaging = {
   folderInfoChangeCache: [],
   unread: {},
   new: {},
+  folderCounts: undefined,
+  folderCountsSeed: undefined,
+  newMailTracker: undefined,
+  readStates: {},
+  folderQueries: {},
+  mailCountDebounce: MAIL_COUNT_DEBOUNCE,
+  mailCountPublisher: {
+    sent: undefined,
+    pending: undefined,
+    timer: undefined,
+    suppressed: 0,
+  },
   displayedFolder: undefined,
+  windowTokens: {},
+  helloTimer: undefined,
+  legacyApp: false,
+  helloAnswered: false,
 
   init: async function () {
-    // Send the startup positions?
-    if (SysTrayX.restorePositions) {
-      SysTrayX.Link.postSysTrayXMessage({
-        positions: SysTrayX.startupWindowPositions,
-      });
-    }
-
-    // Minimize on startup handled by Companion app
-    if (SysTrayX.startupType === "1") {
-        SysTrayX.Link.postSysTrayXMessage({ startup: "minimized" });
-    }
-    if (SysTrayX.startupType === "2") {
-        SysTrayX.Link.postSysTrayXMessage({ startup: "docked" });
-    }
-
     // Lookout for storage changes
     browser.storage.onChanged.addListener(SysTrayX.Messaging.storageChanged);
 
-    //  Request the options from app
-    SysTrayX.Messaging.requestOptions();
-
-    //  Send the platform info to app
-    SysTrayX.Messaging.sendLocale();
-
-    //  Send the platform info to app
-    SysTrayX.Messaging.sendPlatformInfo();
-
-    //  Send the browser info to app
-    SysTrayX.Messaging.sendBrowserInfo();
-
-    //  Send version to app
-    SysTrayX.Messaging.sendVersion();
-
-    //  Send hide default icon preference
-    SysTrayX.Messaging.sendHideDefaultIcon();
-
-    //  Send preferences to app
-    SysTrayX.Messaging.sendPreferences();
-
-    //  Send start app trigger
-    SysTrayX.Messaging.sendStartApp();
+    //  Send the initial state to the app in one go
+    await SysTrayX.Messaging.sendHello();
 
     //  Let us wait until TB is ready, needed for TB91 (no accounts found, cannot create filters) and higher?
     const startupDelay = await storage()
@@ -239,6 +219,81 @@ SysTrayX.Messaging = {
     }
   },
 
+  listenerNewMailTracker: function (folder, messages) {
+    if (!isNewMailTrackerActive() || !isFolderInFilters(folder)) {
+      return;
+    }
+
+    let found = false;
+    for (const message of messages.messages) {
+      found = trackNewMail(folder.accountId, folder.path, message) || found;
+    }
+
+    if (found && SysTrayX.Messaging.startupDelayFinished) {
+      sendMailCount();
+    }
+  },
+
+  listenerMessageUpdated: function (message, changedProperties) {
+    //  Keep the known read states up to date
+    if (
+      changedProperties.read !== undefined &&
+      SysTrayX.Messaging.readStates[message.id] !== undefined
+    ) {
+      SysTrayX.Messaging.readStates[message.id] = changedProperties.read;
+    }
+
+    if (!isNewMailTrackerActive()) {
+      return;
+    }
+
+    if (changedProperties.read === true || changedProperties.new === false) {
+      if (untrackNewMail(message.id) && SysTrayX.Messaging.startupDelayFinished) {
+        sendMailCount();
+      }
+    }
+  },
+
+  listenerMessagesDeleted: function (messages) {
+    for (const message of messages.messages) {
+      delete SysTrayX.Messaging.readStates[message.id];
+    }
+
+    if (!isNewMailTrackerActive()) {
+      return;
+    }
+
+    let found = false;
+    for (const message of messages.messages) {
+      found = untrackNewMail(message.id) || found;
+    }
+
+    if (found && SysTrayX.Messaging.startupDelayFinished) {
+      sendMailCount();
+    }
+  },
+
+  listenerMessagesMoved: function (originalMessages, movedMessages) {
+    if (!isNewMailTrackerActive()) {
+      return;
+    }
+
+    let found = false;
+    for (const message of originalMessages.messages) {
+      found = untrackNewMail(message.id) || found;
+    }
+
+    for (const message of movedMessages.messages) {
+      if (isFolderInFilters(message.folder)) {
+        found = trackNewMail(message.folder.accountId, message.folder.path, message) || found;
+      }
+    }
+
+    if (found && SysTrayX.Messaging.startupDelayFinished) {
+      sendMailCount();
+    }
+  },
+
   listenerFolderInfoChanged: async function (folder, folderInfo) {
     if (SysTrayX.Info.browserInfo.majorVersion < 115 || SysTrayX.Messaging.apiCountMethod === "false") {
 
@@ -278,16 +333,15 @@ SysTrayX.Messaging = {
               const messages = SysTrayX.Messaging.new[cache.folder.accountId][cache.folder.path];
 
               if (messages.length > 0) {
+                const readStates = await getReadStates(messages);
+
                 const newMessages = [];
                 for (let i = 0; i < messages.length; ++i) {
-                  const message = messages[i];
-
-                  const getHeaderPromise = (messageId) =>
-                    new Promise((res) => res(messenger.messages.get(messageId)));
-                  const header = await getHeaderPromise(message.id);
-
-                  if (!header.read) {
-                    newMessages.push(message);
+                  if (readStates[i]) {
+                    //  Never looked up again
+                    delete SysTrayX.Messaging.readStates[messages[i].id];
+                  } else {
+                    newMessages.push(messages[i]);
                   }
                 }
 
@@ -307,58 +361,14 @@ SysTrayX.Messaging = {
         } else {
 
           // Count the initial unread messages
-          for (const filter of SysTrayX.Messaging.filters) {
-            const accountId = filter.accountId;
-            for (const storedFolder of filter.folders) {
-              let path;
-              let folderParam;
-              if (typeof(storedFolder) === "string") {
-                //  Filters pre TB 121
-                path = storedFolder;
-                folderParam = {
-                  accountId: accountId,
-                  path: storedFolder,
-                };
-              } else {
-                //  Filters TB 121
-                if (storedFolder.mailFolderId === undefined) {
-                  //  TB 121 filter setup but older TB
-                  path = storedFolder.path;
-                  folderParam = {
-                    accountId: accountId,
-                    path: path,
-                  };
-                } else {
-                  path = storedFolder.path;
-                  folderParam = storedFolder.mailFolderId;  
-                }
-              }
-        
-              let mailFolderInfo = {};
-              try {
-                mailFolderInfo = await browser.folders.getFolderInfo(folderParam);
-              } catch (err) {
-                console.debug("Filter error: " + err);
-                console.debug("Filter error: " + JSON.stringify(folder));
-              }
-
-              if (mailFolderInfo.unreadMessageCount !== undefined) {
-                if (SysTrayX.Messaging.unread[accountId] === undefined) {
-                  SysTrayX.Messaging.unread[accountId] = {};
-                }
-      
-                SysTrayX.Messaging.unread[accountId][path] =
-                  mailFolderInfo.unreadMessageCount;
-              }
-            }
-          }
+          await countUnreadMail(false);
         }
         sendMailCountPre115();
       }
     } else {
       if (SysTrayX.Messaging.startupDelayFinished)
       {
-        sendMailCount();
+        sendMailCount(folder, folderInfo);
       }
     }
   },
@@ -399,7 +409,61 @@ SysTrayX.Messaging = {
   onNewWindow: async function (id) {
     SysTrayX.Messaging.showHideForceCloseButton();
 
-    SysTrayX.Link.postSysTrayXMessage({ newWindow: id });
+    //  Only the X11 window control matches the token, the others find the window by elimination.
+    //  An app without the handshake only accepts the numeric id.
+    const os = SysTrayX.Info.platformInfo.os;
+    if (os === "win" || os === "mac" || !SysTrayX.Messaging.helloAnswered) {
+      SysTrayX.Link.postSysTrayXMessage({ newWindow: id });
+      return;
+    }
+
+    //  Stamp the title with a unique token, the companion matches it with the X11 window title
+    const token = `[SysTray-X ${id}:${Math.random().toString(36).slice(2, 8)}]`;
+    let before;
+    try {
+      before = await browser.windows.get(id);
+      await browser.windows.update(id, { titlePreface: `${token} ` });
+    } catch (error) {
+      //  No title preface, let the companion find the window by elimination
+      SysTrayX.Link.postSysTrayXMessage({ newWindow: id });
+      return;
+    }
+
+    //  The preface is not readable, derive one set before from the title change
+    let preface = "";
+    try {
+      const after = await browser.windows.get(id);
+      if (
+        typeof before.title === "string" &&
+        typeof after.title === "string" &&
+        after.title.startsWith(`${token} `)
+      ) {
+        const base = after.title.slice(token.length + 1);
+        if (before.title.endsWith(base)) {
+          preface = before.title.slice(0, before.title.length - base.length);
+        }
+      }
+    } catch (error) {
+      //  Window already closed
+    }
+
+    SysTrayX.Messaging.windowTokens[id] = { token: token, preface: preface };
+
+    SysTrayX.Link.postSysTrayXMessage({ newWindow: { id: id, token: token } });
+  },
+
+  onWindowIdentified: async function (id) {
+    const stamp = SysTrayX.Messaging.windowTokens[id];
+    if (stamp !== undefined) {
+      delete SysTrayX.Messaging.windowTokens[id];
+
+      //  Remove the token from the title, restore the preface it replaced
+      try {
+        await browser.windows.update(id, { titlePreface: stamp.preface });
+      } catch (error) {
+        //  Window already closed
+      }
+    }
   },
 
   onCloseButton: async function (id, quit) {
@@ -424,11 +488,21 @@ SysTrayX.Messaging = {
   storageChanged: async function (changes, area) {
     //  Get the new preferences
 
+    //  A save from the options page arrives as one change set,
+    //  count the mails only once for it
+    let recount = false;
+
     if ("filters" in changes && changes["filters"].newValue) {
       SysTrayX.Messaging.filters = changes["filters"].newValue;
 
-      sendMailCountPre115();
-      sendMailCount();
+      //  Other folders, count them again
+      resetFolderCounts();
+
+      recount = true;
+    }
+
+    if ("mailCountDebounce" in changes && changes["mailCountDebounce"].newValue !== undefined) {
+      SysTrayX.Messaging.mailCountDebounce = Number(changes["mailCountDebounce"].newValue);
     }
 
     if ("closeType" in changes && changes["closeType"].newValue) {
@@ -458,13 +532,16 @@ SysTrayX.Messaging = {
     if ("countType" in changes && changes["countType"].newValue) {
       SysTrayX.Messaging.countType = changes["countType"].newValue;
 
-      sendMailCountPre115();
-      sendMailCount();
+      recount = true;
     }
 
     if ("showNewIndicator" in changes && changes["showNewIndicator"].newValue) {
       SysTrayX.Messaging.showNewIndicator = changes["showNewIndicator"].newValue;
 
+      recount = true;
+    }
+
+    if (recount) {
       sendMailCountPre115();
       sendMailCount();
     }
@@ -482,39 +559,83 @@ SysTrayX.Messaging = {
     }
   },
 
-  requestOptions: function () {
-    SysTrayX.Link.postSysTrayXMessage({ optionsRequest: true });
-  },
+  //
+  //  Send the startup handshake, the full initial state in one message
+  //
+  sendHello: async function () {
+    let hello = {
+      protocol: HELLO_PROTOCOL,
+      version: SysTrayX.Info.version,
+      platformInfo: SysTrayX.Info.platformInfo,
+      browserInfo: SysTrayX.Info.browserInfo,
+      locale: browser.i18n.getUILanguage(),
+      hideDefaultIcon: SysTrayX.hideDefaultIcon,
+      preferences: await SysTrayX.Messaging.getPreferences(),
+    };
 
-  sendBrowserInfo: function () {
-    const info = SysTrayX.Info.browserInfo;
-    SysTrayX.Link.postSysTrayXMessage({ browserInfo: info });
-  },
+    // Send the startup positions?
+    if (SysTrayX.restorePositions) {
+      hello.positions = SysTrayX.startupWindowPositions;
+    }
 
-  sendPlatformInfo: function () {
-    const info = SysTrayX.Info.platformInfo;
-    SysTrayX.Link.postSysTrayXMessage({ platformInfo: info });
-  },
+    // Minimize on startup handled by Companion app
+    if (SysTrayX.startupType === "1") {
+      hello.startup = "minimized";
+    }
+    if (SysTrayX.startupType === "2") {
+      hello.startup = "docked";
+    }
 
-  sendVersion: function () {
-    SysTrayX.Link.postSysTrayXMessage({ version: SysTrayX.Info.version });
-  },
+    SysTrayX.Link.postSysTrayXMessage({ hello: hello });
 
-  sendHideDefaultIcon: function () {
-    SysTrayX.Link.postSysTrayXMessage({
-      hideDefaultIcon: SysTrayX.hideDefaultIcon,
-    });
+    //  An older app ignores the hello, fall back to the separate frames
+    SysTrayX.Messaging.helloTimer = setTimeout(
+      SysTrayX.Messaging.sendLegacyStartup,
+      HELLO_TIMEOUT
+    );
   },
 
-  sendLocale: function () {
-    const locale = browser.i18n.getUILanguage();
+  //
+  //  Send the initial state as separate frames, for an app without the handshake
+  //
+  sendLegacyStartup: async function () {
+    SysTrayX.Messaging.helloTimer = undefined;
+    SysTrayX.Messaging.legacyApp = true;
+
+    console.log("No handshake answer, sending the legacy startup messages");
 
+    // Send the startup positions?
+    if (SysTrayX.restorePositions) {
+      SysTrayX.Link.postSysTrayXMessage({
+        positions: SysTrayX.startupWindowPositions,
+      });
+    }
+
+    // Minimize on startup handled by Companion app
+    if (SysTrayX.startupType === "1") {
+      SysTrayX.Link.postSysTrayXMessage({ startup: "minimized" });
+    }
+    if (SysTrayX.startupType === "2") {
+      SysTrayX.Link.postSysTrayXMessage({ startup: "docked" });
+    }
+
+    SysTrayX.Link.postSysTrayXMessage({ optionsRequest: true });
     SysTrayX.Link.postSysTrayXMessage({
-      locale: locale,
+      locale: browser.i18n.getUILanguage(),
     });
-  },
+    SysTrayX.Link.postSysTrayXMessage({
+      platformInfo: SysTrayX.Info.platformInfo,
+    });
+    SysTrayX.Link.postSysTrayXMessage({
+      browserInfo: SysTrayX.Info.browserInfo,
+    });
+    SysTrayX.Link.postSysTrayXMessage({ version: SysTrayX.Info.version });
+    SysTrayX.Link.postSysTrayXMessage({
+      hideDefaultIcon: SysTrayX.hideDefaultIcon,
+    });
+
+    await SysTrayX.Messaging.sendPreferences();
 
-  sendStartApp: function () {
     SysTrayX.Link.postSysTrayXMessage({
       startApp: SysTrayX.startApp,
       startAppArgs: SysTrayX.startAppArgs,
@@ -527,8 +648,8 @@ SysTrayX.Messaging = {
     });
   },
 
-  sendPreferences: async function () {
-    await storage()
+  getPreferences: async function () {
+    return await storage()
       .get([
         "debug",
         "minimizeType",
@@ -564,12 +685,21 @@ SysTrayX.Messaging = {
         "showHideShortcut",
       ])
       .then(
-        SysTrayX.Messaging.sendPreferencesStorage,
+        SysTrayX.Messaging.encodePreferences,
         SysTrayX.Messaging.onSendPreferecesStorageError
       );
   },
 
-  sendPreferencesStorage: function (result) {
+  sendPreferences: async function () {
+    const preferences = await SysTrayX.Messaging.getPreferences();
+
+    //  Send it to the app
+    SysTrayX.Link.postSysTrayXMessage({
+      preferences: preferences,
+    });
+  },
+
+  encodePreferences: async function (result) {
     const debug = result.debug || "false";
     const minimizeType = result.minimizeType || "1";
     const minimizeIconType = result.minimizeIconType || "1";
@@ -608,41 +738,69 @@ SysTrayX.Messaging = {
     const closeAppArgs = result.closeAppArgs || "";
     const showHideShortcut = result.showHideShortcut || "";
 
-    //  Send it to the app
+    let preferences = {
+      debug,
+      minimizeType,
+      minimizeIconType,
+      closeType,
+      startupType,
+      windowPosCor,
+      windowPosCorType,
+      restorePositions,
+      defaultIconType,
+      defaultIconMime,
+      hideDefaultIcon,
+      iconType,
+      iconMime,
+      invertIcon,
+      showNumber,
+      showNewIndicator,
+      countType,
+      startupDelay,
+      apiCountMethod,
+      numberColor,
+      numberSize,
+      numberAlignment,
+      numberMargins,
+      newIndicatorType,
+      newShadeColor,
+      startApp,
+      startAppArgs,
+      closeApp,
+      closeAppArgs,
+      showHideShortcut,
+    };
+
+    if (SysTrayX.Messaging.legacyApp) {
+      //  An app without the handshake never requests the icons, send the data
+      preferences.defaultIcon = defaultIcon;
+      preferences.icon = icon;
+    } else {
+      //  Send the icons by hash, the app requests the data if its cached icons differ
+      preferences.defaultIconHash = await getIconHash(defaultIcon);
+      preferences.iconHash = await getIconHash(icon);
+    }
+
+    return preferences;
+  },
+
+  //
+  //  Send the icon data on request of the app
+  //
+  sendIcons: async function () {
+    const result = await storage().get([
+      "defaultIconMime",
+      "defaultIcon",
+      "iconMime",
+      "icon",
+    ]);
+
     SysTrayX.Link.postSysTrayXMessage({
       preferences: {
-        debug,
-        minimizeType,
-        minimizeIconType,
-        closeType,
-        startupType,
-        windowPosCor,
-        windowPosCorType,
-        restorePositions,
-        defaultIconType,
-        defaultIconMime,
-        defaultIcon,
-        hideDefaultIcon,
-        iconType,
-        iconMime,
-        icon,
-        invertIcon,
-        showNumber,
-        showNewIndicator,
-        countType,
-        startupDelay,
-        apiCountMethod,
-        numberColor,
-        numberSize,
-        numberAlignment,
-        numberMargins,
-        newIndicatorType,
-        newShadeColor,
-        startApp,
-        startAppArgs,
-        closeApp,
-        closeAppArgs,
-        showHideShortcut,
+        defaultIconMime: result.defaultIconMime || "image/png",
+        defaultIcon: result.defaultIcon || [],
+        iconMime: result.iconMime || "image/png",
+        icon: result.icon || [],
       },
     });
   },
@@ -691,7 +849,21 @@ SysTrayX.Link = {
       SysTrayX.Link.postSysTrayXMessage({ shutdown: "true" });
     }
 
-    const options = response["options"];
+    //  Handshake answer, carries the options
+    const hello = response["hello"];
+    if (hello !== undefined) {
+      if (SysTrayX.Messaging.helloTimer !== undefined) {
+        clearTimeout(SysTrayX.Messaging.helloTimer);
+        SysTrayX.Messaging.helloTimer = undefined;
+      }
+      SysTrayX.Messaging.legacyApp = false;
+      SysTrayX.Messaging.helloAnswered = true;
+    }
+    if (hello !== undefined && hello.protocol !== HELLO_PROTOCOL) {
+      console.log(`Handshake protocol mismatch: add-on ${HELLO_PROTOCOL}, app ${hello.protocol}`);
+    }
+
+    const options = hello !== undefined ? hello.options : response["options"];
     if (options !== undefined) {
       SysTrayX.Info.options = options;
 
@@ -700,6 +872,15 @@ SysTrayX.Link = {
       });
     }
 
+    if (response["iconRequest"]) {
+      SysTrayX.Messaging.sendIcons();
+    }
+
+    const windowIdentified = response["windowIdentified"];
+    if (windowIdentified !== undefined) {
+      SysTrayX.Messaging.onWindowIdentified(windowIdentified);
+    }
+
     const positions = response["positions"];
     if (positions) {
       await storage().set({
@@ -848,6 +1029,10 @@ SysTrayX.Link = {
           apiCountMethod: apiCountMethod,
         });
         SysTrayX.Messaging.apiCountMethod = apiCountMethod;
+
+        //  The folder counts are not tracked by the other method
+        resetFolderCounts();
+        resetNewMailTracker();
       }
   
       const numberColor = response["preferences"].numberColor;
@@ -938,15 +1123,31 @@ SysTrayX.Link = {
 };
 
 SysTrayX.Window = {
+  //  Last state sent per window id
+  states: {},
+
   focusChanged: async function (windowId) {
 
     const windows_all = await browser.windows.getAll();
     //console.debug("focusChanged windows: " + JSON.stringify(windows_all));
 
-    const windows = windows_all.map( (win) => { return {id: win.id, state: win.state} });
+    //  Only the windows with a changed state
+    const states = {};
+    const windows = [];
+    for (const win of windows_all) {
+      states[win.id] = win.state;
+      if (SysTrayX.Window.states[win.id] !== win.state) {
+        windows.push({ id: win.id, state: win.state });
+      }
+    }
+
+    //  Closed windows are dropped
+    SysTrayX.Window.states = states;
     //console.debug("focusChanged windows: " + JSON.stringify(windows));
 
-    SysTrayX.Link.postSysTrayXMessage({ windows: windows } );
+    if (windows.length > 0) {
+      SysTrayX.Link.postSysTrayXMessage({ windows: windows } );
+    }
   },
 
   folderChanged: function (tab, displayedFolder) {
@@ -963,6 +1164,12 @@ SysTrayX.Window = {
             oldDisplayedFolder.path
           ] !== undefined
         ) {
+          for (const message of SysTrayX.Messaging.new[oldDisplayedFolder.accountId][
+            oldDisplayedFolder.path
+          ]) {
+            delete SysTrayX.Messaging.readStates[message.id];
+          }
+
           SysTrayX.Messaging.new[oldDisplayedFolder.accountId][
             oldDisplayedFolder.path
           ] = [];
@@ -975,6 +1182,14 @@ SysTrayX.Window = {
 
       SysTrayX.Messaging.displayedFolder = displayedFolder;
     } else {
+      //  Leaving a folder resets its new mails
+      const oldDisplayedFolder = SysTrayX.Messaging.displayedFolder;
+      if (oldDisplayedFolder !== undefined && isNewMailTrackerActive()) {
+        clearNewMailFolder(oldDisplayedFolder.accountId, oldDisplayedFolder.path);
+      }
+
+      SysTrayX.Messaging.displayedFolder = displayedFolder;
+
       if (SysTrayX.Messaging.startupDelayFinished) {
         sendMailCount();
       }
@@ -1020,6 +1235,9 @@ async function start() {
   const apiCountMethod = await getApiCountMethod();
   SysTrayX.Messaging.apiCountMethod = apiCountMethod;
 
+  //  Get the mail count debounce window
+  SysTrayX.Messaging.mailCountDebounce = Number(await getMailCountDebounce());
+
   // Try to catch the mails
   if (SysTrayX.Info.browserInfo.majorVersion < 115 || SysTrayX.Messaging.apiCountMethod === "false") {
     // Catch the new incomming mail
@@ -1028,6 +1246,27 @@ async function start() {
     );
   }
 
+  //  Track the read state and new mail changes
+  if (browser.messages.onUpdated !== undefined) {
+    browser.messages.onUpdated.addListener(
+      SysTrayX.Messaging.listenerMessageUpdated
+    );
+  }
+  browser.messages.onDeleted.addListener(
+    SysTrayX.Messaging.listenerMessagesDeleted
+  );
+
+  //  Track the new mails for the API count method (TB 115 - 120)
+  resetNewMailTracker();
+  if (SysTrayX.Info.browserInfo.majorVersion >= 115 && SysTrayX.Info.browserInfo.majorVersion < 121) {
+    browser.messages.onNewMailReceived.addListener(
+      SysTrayX.Messaging.listenerNewMailTracker
+    );
+    browser.messages.onMoved.addListener(
+      SysTrayX.Messaging.listenerMessagesMoved
+    );
+  }
+
   //  Set catch folder changes
   browser.folders.onFolderInfoChanged.addListener(
     SysTrayX.Messaging.listenerFolderInfoChanged
@@ -6,6 +6,16 @@ function storage() {
     return browser.storage.local;
 }
 
+//
+//  Version of the startup handshake with the app
+//
+const HELLO_PROTOCOL = 1;
+
+//
+//  Time to wait for the handshake answer before assuming an older app (ms)
+//
+const HELLO_TIMEOUT = 3000;
+
 //
 //  Get API count method preference
 //
@@ -219,6 +229,26 @@ async function getIcon() {
   }
 }
 
+//
+//  Get the SHA-256 of a base64 icon, as hex string
+//  Matches the hash of the decoded icon data in the app
+//
+async function getIconHash(iconBase64) {
+  let binary = "";
+  try {
+    binary = typeof iconBase64 === "string" ? atob(iconBase64) : "";
+  } catch (error) {
+    //  Unknown data, never matches so the app requests it
+    return "";
+  }
+  const bytes = Uint8Array.from(binary, (c) => c.charCodeAt(0));
+
+  const digest = await crypto.subtle.digest("SHA-256", bytes);
+
+  return Array.from(new Uint8Array(digest))
+    .map((b) => b.toString(16).padStart(2, "0"))
+    .join("");
+}
 
 //
 //  Find a path in the account folder tree
@@ -420,6 +450,23 @@ async function getCountType() {
   return await storage().get("countType").then(resolve, reject);
 }
 
+//
+//  Get the mail count debounce window
+//
+async function getMailCountDebounce() {
+  function resolve(result) {
+    return result.mailCountDebounce !== undefined
+      ? result.mailCountDebounce
+      : String(MAIL_COUNT_DEBOUNCE);
+  }
+
+  function reject() {
+    return String(MAIL_COUNT_DEBOUNCE);
+  }
+
+  return await storage().get("mailCountDebounce").then(resolve, reject);
+}
+
 //
 //  Get show new indicator
 //
@@ -469,7 +516,7 @@ function isFolderInFilters(folder) {
   if (accountIndex !== -1) {
     const folders = SysTrayX.Messaging.filters[accountIndex].folders;
 
-    if (folders[0] === "string") {
+    if (typeof(folders[0]) === "string") {
       //  Filters pre TB 121
       return (
         folders.filter(
@@ -500,7 +547,7 @@ function isParentFolderInFilters(folder) {
   if (accountIndex !== -1) {
     const folders = SysTrayX.Messaging.filters[accountIndex].folders;
 
-    if (folders[0] === "string") {
+    if (typeof(folders[0]) === "string") {
       //  Filters pre TB 121
       return (
         folders.filter(
@@ -575,74 +622,179 @@ async function addFolderToFilters(newFolder) {
   }
 }
 
-// Collect unread mail
-const collectUnreadMail = async () => {
+//  Number of concurrent folder info queries
+const FOLDER_INFO_CONCURRENCY = 8;
+
+//  Get all filtered folders with their folder info parameter
+function getFilterFolders() {
+  let folders = [];
   for (const filter of SysTrayX.Messaging.filters) {
-    
     const accountId = filter.accountId;
     for (const storedFolder of filter.folders) {
-      let mailFolderInfo = {};
-
       let path;
+      let folderParam;
       if (typeof(storedFolder) === "string") {
         //  Filters pre TB 121
         path = storedFolder;
-
-        try {
-          mailFolderInfo = await browser.folders.getFolderInfo({
-              accountId: accountId,
-              path: storedFolder,
-            });
-        } catch (err) {
-          //console.debug("Filter error: " + err);
-          //console.debug("Filter error: " + JSON.stringify(folder));
-
-          //  Get all accounts
-          SysTrayX.Messaging.accounts = await browser.accounts.list();
-
-          // Check the filters for the accounts
-          SysTrayX.Messaging.accountFilterCheck();
-        }
+        folderParam = {
+          accountId: accountId,
+          path: storedFolder,
+        };
       } else {
         //  Filters TB 121
         path = storedFolder.path;
-        
-        try {
-          mailFolderInfo = await browser.folders.getFolderInfo(storedFolder.mailFolderId);
-        } catch (err) {
-          //console.debug("Filter error: " + err);
-          //console.debug("Filter error: " + JSON.stringify(folder));
-
-          //  Get all accounts
-          SysTrayX.Messaging.accounts = await browser.accounts.list();
-
-          // Check the filters for the accounts
-          SysTrayX.Messaging.accountFilterCheck();
+        if (storedFolder.mailFolderId === undefined) {
+          //  TB 121 filter setup but older TB
+          folderParam = {
+            accountId: accountId,
+            path: path,
+          };
+        } else {
+          folderParam = storedFolder.mailFolderId;
         }
       }
 
-      if (mailFolderInfo.unreadMessageCount !== undefined) {
-        if (SysTrayX.Messaging.unread[accountId] === undefined) {
-          SysTrayX.Messaging.unread[accountId] = {};
-        }
+      folders.push({ accountId: accountId, path: path, folderParam: folderParam });
+    }
+  }
+
+  return folders;
+}
+
+//  Get the folder info of folders, a newer query of the same kind cancels this one
+const queryFolderInfos = async (folders, kind) => {
+  const queries = SysTrayX.Messaging.folderQueries;
+  const generation = (queries[kind] || 0) + 1;
+  queries[kind] = generation;
+
+  const cancelled = () => queries[kind] !== generation;
+
+  let failed = false;
+  const infos = await mapConcurrent(folders, FOLDER_INFO_CONCURRENCY, async (folder) => {
+    try {
+      return await browser.folders.getFolderInfo(folder.folderParam);
+    } catch (err) {
+      //console.debug("Filter error: " + err);
+      //console.debug("Filter error: " + JSON.stringify(folder));
+      failed = true;
+      return {};
+    }
+  }, cancelled);
 
+  if (failed) {
+    //  Get all accounts
+    SysTrayX.Messaging.accounts = await browser.accounts.list();
+
+    // Check the filters for the accounts
+    SysTrayX.Messaging.accountFilterCheck();
+  }
+
+  return cancelled() ? undefined : infos;
+};
+
+//  Store the unread count of folders
+function storeUnreadMail(folders, infos, initNew) {
+  folders.forEach((folder, i) => {
+    const accountId = folder.accountId;
+    const path = folder.path;
+    const mailFolderInfo = infos[i];
+
+    if (mailFolderInfo.unreadMessageCount !== undefined) {
+      if (SysTrayX.Messaging.unread[accountId] === undefined) {
+        SysTrayX.Messaging.unread[accountId] = {};
+      }
+
+      if (initNew) {
         if (SysTrayX.Messaging.new[accountId] === undefined) {
           SysTrayX.Messaging.new[accountId] = {};
         }
 
-        if (
-          SysTrayX.Messaging.new[accountId][path] === undefined
-        ) {
+        if (SysTrayX.Messaging.new[accountId][path] === undefined) {
           SysTrayX.Messaging.new[accountId][path] = [];
         }
-
-        SysTrayX.Messaging.unread[accountId][path] =
-          mailFolderInfo.unreadMessageCount;
       }
+
+      SysTrayX.Messaging.unread[accountId][path] =
+        mailFolderInfo.unreadMessageCount;
     }
+  });
+}
+
+//  Count the unread mail of all filtered folders
+const countUnreadMail = async (initNew) => {
+  const folders = getFilterFolders();
+  const infos = await queryFolderInfos(folders, "unread");
+
+  //  Superseded by a newer count
+  if (infos !== undefined) {
+    storeUnreadMail(folders, infos, initNew);
   }
 };
 
+// Collect unread mail
+const collectUnreadMail = async () => {
+  await countUnreadMail(true);
+};
+
+//  Default debounce window of the mail count (ms)
+const MAIL_COUNT_DEBOUNCE = 250;
+
+//  Send the pending mail count, unless unchanged
+function flushMailCount() {
+  const publisher = SysTrayX.Messaging.mailCountPublisher;
+  const count = publisher.pending;
+  publisher.pending = undefined;
+
+  if (count === undefined) {
+    return false;
+  }
+
+  if (
+    publisher.sent !== undefined &&
+    publisher.sent.unread === count.unread &&
+    publisher.sent.new === count.new
+  ) {
+    publisher.suppressed = publisher.suppressed + 1;
+    return false;
+  }
+
+  publisher.sent = count;
+
+  //console.debug("Mail count: unread " + count.unread + ", new " + count.new + ", suppressed " + publisher.suppressed);
+
+  SysTrayX.Link.postSysTrayXMessage( { mailCount: count } );
+
+  return true;
+}
+
+//  End of a debounce window, send the last count
+function mailCountTimeout() {
+  const publisher = SysTrayX.Messaging.mailCountPublisher;
+
+  if (flushMailCount()) {
+    //  Keep the window open after a send
+    publisher.timer = setTimeout(mailCountTimeout, SysTrayX.Messaging.mailCountDebounce);
+  } else {
+    publisher.timer = undefined;
+  }
+}
+
+//  Publish the mail count, first and last of a burst, only when changed
+function publishMailCount(unreadCount, newCount) {
+  const publisher = SysTrayX.Messaging.mailCountPublisher;
+
+  if (publisher.pending !== undefined) {
+    //  Replaced within the window
+    publisher.suppressed = publisher.suppressed + 1;
+  }
+  publisher.pending = { unread: unreadCount, new: newCount };
+
+  if (publisher.timer === undefined) {
+    flushMailCount();
+    publisher.timer = setTimeout(mailCountTimeout, SysTrayX.Messaging.mailCountDebounce);
+  }
+}
+
 //  Count and send the unread and new mails
 const sendMailCountPre115 = () => {
   if (SysTrayX.Info.browserInfo.majorVersion < 115 || SysTrayX.Messaging.apiCountMethod === "false") {
@@ -685,12 +837,279 @@ const sendMailCountPre115 = () => {
     //console.debug("sendMailCountPre115 Unread: " + unreadCount);
     //console.debug("sendMailCountPre115 New: " + newCount);
 
-    SysTrayX.Link.postSysTrayXMessage( { mailCount: { unread: unreadCount, new: newCount } } );
+    publishMailCount(unreadCount, newCount);
+  }
+};
+
+//  Number of concurrent message header lookups
+const HEADER_LOOKUP_CONCURRENCY = 8;
+
+//  Run an async function on all items, at most limit at a time, until cancelled
+const mapConcurrent = async (items, limit, fn, cancelled) => {
+  const results = new Array(items.length);
+
+  let next = 0;
+  const worker = async () => {
+    while (next < items.length && !(cancelled !== undefined && cancelled())) {
+      const index = next++;
+      results[index] = await fn(items[index], index);
+    }
+  };
+
+  const workers = [];
+  for (let i = 0; i < Math.min(limit, items.length); ++i) {
+    workers.push(worker());
+  }
+  await Promise.all(workers);
+
+  return results;
+};
+
+//  Get the read state of messages, known states from the cache
+const getReadStates = async (messages) => {
+  const cache = SysTrayX.Messaging.readStates;
+
+  return mapConcurrent(messages, HEADER_LOOKUP_CONCURRENCY, async (message) => {
+    if (cache[message.id] === undefined) {
+      try {
+        const header = await messenger.messages.get(message.id);
+        cache[message.id] = header.read;
+      } catch (err) {
+        //  Message is gone, no longer new
+        return true;
+      }
+    }
+
+    return cache[message.id];
+  });
+};
+
+//  Key of a folder in the folder count table
+function getFolderCountKey(accountId, path) {
+  return accountId + path;
+}
+
+//  Get the count of all filtered folders
+const collectFolderCounts = async () => {
+  const folders = getFilterFolders();
+  const infos = await queryFolderInfos(folders, "counts");
+
+  //  Superseded by a newer count
+  if (infos === undefined) {
+    return undefined;
+  }
+
+  let counts = { folders: {}, unread: 0, new: 0 };
+  folders.forEach((folder, i) => {
+    const entry = { unread: 0, new: 0 };
+    counts.folders[getFolderCountKey(folder.accountId, folder.path)] = entry;
+
+    applyFolderCount(counts, entry, infos[i]);
+  });
+
+  return counts;
+};
+
+//  Apply the new counts of a folder as a delta on the totals
+function applyFolderCount(counts, entry, folderInfo) {
+  if (folderInfo.unreadMessageCount !== undefined) {
+    counts.unread = counts.unread + folderInfo.unreadMessageCount - entry.unread;
+    entry.unread = folderInfo.unreadMessageCount;
   }
+
+  if (folderInfo.newMessageCount !== undefined) {
+    counts.new = counts.new + folderInfo.newMessageCount - entry.new;
+    entry.new = folderInfo.newMessageCount;
+  }
+}
+
+//  Drop the folder count table, the next count seeds it again
+function resetFolderCounts() {
+  SysTrayX.Messaging.folderCounts = undefined;
+  SysTrayX.Messaging.folderCountsSeed = undefined;
+}
+
+//  Seed the folder count table, only once for concurrent callers
+const seedFolderCounts = () => {
+  if (SysTrayX.Messaging.folderCountsSeed === undefined) {
+    const seed = collectFolderCounts().then((counts) => {
+      //  Ignore a seed that was reset while collecting
+      if (counts !== undefined && SysTrayX.Messaging.folderCountsSeed === seed) {
+        SysTrayX.Messaging.folderCounts = counts;
+      }
+    });
+    SysTrayX.Messaging.folderCountsSeed = seed;
+  }
+
+  return SysTrayX.Messaging.folderCountsSeed;
+};
+
+//  Get the unread and new totals, updated with a folder info change
+const getFolderCountTotals = async (folder, folderInfo) => {
+  while (SysTrayX.Messaging.folderCounts === undefined) {
+    await seedFolderCounts();
+  }
+
+  const counts = SysTrayX.Messaging.folderCounts;
+  if (folder !== undefined && folderInfo !== undefined) {
+    const entry = counts.folders[getFolderCountKey(folder.accountId, folder.path)];
+    if (entry !== undefined) {
+      applyFolderCount(counts, entry, folderInfo);
+    }
+  }
+
+  return { unread: counts.unread, new: counts.new };
+};
+
+//  Delay between the pages of the new mail scan (ms)
+const NEW_MAIL_SCAN_PAGE_DELAY = 50;
+
+//  Is the new mail tracker in use (TB 115 - 120)
+function isNewMailTrackerActive() {
+  return (
+    SysTrayX.Info.browserInfo.majorVersion >= 115 &&
+    SysTrayX.Info.browserInfo.majorVersion < 121 &&
+    SysTrayX.Messaging.apiCountMethod === "true"
+  );
+}
+
+//  Drop all tracked new mails, the folders will be scanned again
+function resetNewMailTracker() {
+  SysTrayX.Messaging.newMailTracker = {
+    folders: {},
+    index: {},
+    scanned: {},
+    scan: Promise.resolve(),
+  };
+}
+
+//  Track a new mail of a folder
+function trackNewMail(accountId, path, message) {
+  const tracker = SysTrayX.Messaging.newMailTracker;
+  if (!message.new || message.read || tracker.index[message.id] !== undefined) {
+    return false;
+  }
+
+  const key = getFolderCountKey(accountId, path);
+  if (tracker.folders[key] === undefined) {
+    tracker.folders[key] = new Set();
+  }
+
+  tracker.folders[key].add(message.id);
+  tracker.index[message.id] = key;
+
+  return true;
+}
+
+//  Stop tracking a mail
+function untrackNewMail(messageId) {
+  const tracker = SysTrayX.Messaging.newMailTracker;
+  const key = tracker.index[messageId];
+  if (key === undefined) {
+    return false;
+  }
+
+  tracker.folders[key].delete(messageId);
+  delete tracker.index[messageId];
+
+  return true;
+}
+
+//  Stop tracking all mails of a folder
+function clearNewMailFolder(accountId, path) {
+  const tracker = SysTrayX.Messaging.newMailTracker;
+  const key = getFolderCountKey(accountId, path);
+  if (tracker.folders[key] === undefined || tracker.folders[key].size === 0) {
+    return false;
+  }
+
+  for (const messageId of tracker.folders[key]) {
+    delete tracker.index[messageId];
+  }
+  tracker.folders[key].clear();
+
+  return true;
+}
+
+//  Number of tracked new mails in the filtered folders
+function getNewMailTrackerCount() {
+  const tracker = SysTrayX.Messaging.newMailTracker;
+
+  let count = 0;
+  for (const filter of SysTrayX.Messaging.filters) {
+    for (const storedFolder of filter.folders) {
+      const path = typeof(storedFolder) === "string" ? storedFolder : storedFolder.path;
+      const messages = tracker.folders[getFolderCountKey(filter.accountId, path)];
+      if (messages !== undefined) {
+        count = count + messages.size;
+      }
+    }
+  }
+
+  return count;
+}
+
+//  Find the new mails of a folder, page by page
+const scanNewMailFolder = async (accountId, path) => {
+  let found = false;
+  try {
+    let page = await messenger.messages.list({ accountId: accountId, path: path });
+    for (;;) {
+      for (const message of page.messages) {
+        found = trackNewMail(accountId, path, message) || found;
+      }
+
+      if (!page.id) {
+        break;
+      }
+
+      //  Do not hog Thunderbird
+      await new Promise((res) => setTimeout(res, NEW_MAIL_SCAN_PAGE_DELAY));
+
+      page = await messenger.messages.continueList(page.id);
+    }
+  } catch (err) {
+    //console.debug("Scan error: " + err);
+  }
+
+  return found;
 };
 
+//  Scan the filtered folders not scanned before, in the background
+function scanNewMail() {
+  const tracker = SysTrayX.Messaging.newMailTracker;
+
+  let folders = [];
+  for (const filter of SysTrayX.Messaging.filters) {
+    for (const storedFolder of filter.folders) {
+      const path = typeof(storedFolder) === "string" ? storedFolder : storedFolder.path;
+      const key = getFolderCountKey(filter.accountId, path);
+      if (!tracker.scanned[key]) {
+        tracker.scanned[key] = true;
+        folders.push({ accountId: filter.accountId, path: path });
+      }
+    }
+  }
+
+  if (folders.length === 0) {
+    return;
+  }
+
+  //  Queue the scan after a running one
+  tracker.scan = tracker.scan.then(async () => {
+    let found = false;
+    for (const folder of folders) {
+      found = (await scanNewMailFolder(folder.accountId, folder.path)) || found;
+    }
+
+    if (found && tracker === SysTrayX.Messaging.newMailTracker) {
+      sendMailCount();
+    }
+  });
+}
+
 //  Count and send the unread and new mails (>TB115)
-const sendMailCount = async () => {
+const sendMailCount = async (folder, folderInfo) => {
   if (SysTrayX.Info.browserInfo.majorVersion >= 115 && SysTrayX.Messaging.apiCountMethod === "true") {
 
     // New only works for >=TB106 
@@ -703,123 +1122,34 @@ const sendMailCount = async () => {
       //  Get both unread and new message count
 
       if (SysTrayX.Info.browserInfo.majorVersion < 121) {
-        for (const filter of SysTrayX.Messaging.filters) {
-          for (const storedFolder of filter.folders) {
-            let listParam;
-            if (typeof(storedFolder) === "string") {
-              //  Filters pre TB 121
-              listParam = {
-                accountId: filter.accountId,
-                path: storedFolder,
-              };  
-            } else {
-              //  Filters TB 121
-              listParam = {
-                accountId: filter.accountId,
-                path: storedFolder.path,
-              };
-            }
 
-            async function* listMessages(listParam) {
-              let page = await messenger.messages.list(listParam);
-              for (let message of page.messages) {
-                yield message;
-              }
-            
-              while (page.id) {
-                page = await messenger.messages.continueList(page.id);
-                for (let message of page.messages) {
-                  yield message;
-                }
-              }
-            }
-            
-            let messages = listMessages(listParam);
-            for await (let message of messages) {
-              if( message.new )
-              {
-                newCount = newCount + 1;
-              }
+        //  Unread count from the folders, new count from the tracker
 
-              if( !message.read )
-              {
-                unreadCount = unreadCount + 1;
-              }
-            }
-          }
-        }
+        const totals = await getFolderCountTotals(folder, folderInfo);
+        unreadCount = totals.unread;
+        newCount = getNewMailTrackerCount();
+
+        //  Find the new mails in not yet scanned folders
+        scanNewMail();
       } else {
 
         //  Unread and new count TB 121 and newer
 
-        for (const filter of SysTrayX.Messaging.filters) {
-          for (const folder of filter.folders) {
-            let mailFolderInfo = {};
-            try {
-              mailFolderInfo = await browser.folders.getFolderInfo(folder.mailFolderId);
-            } catch (err) {
-              //console.debug("Filter error: " + err);
-              //console.debug("Filter error: " + JSON.stringify(folder));
-      
-              //  Get all accounts
-              SysTrayX.Messaging.accounts = await browser.accounts.list();
-      
-              // Check the filters for the accounts
-              SysTrayX.Messaging.accountFilterCheck();
-            }
-
-            if (mailFolderInfo.unreadMessageCount !== undefined) {
-              unreadCount = unreadCount + mailFolderInfo.unreadMessageCount;
-            }
-
-            if (mailFolderInfo.newMessageCount !== undefined) {
-              newCount = newCount + mailFolderInfo.newMessageCount;
-            }
-          }
-        }
+        const totals = await getFolderCountTotals(folder, folderInfo);
+        unreadCount = totals.unread;
+        newCount = totals.new;
       }
     } else {
 
       //  Only unread count
 
-      for (const filter of SysTrayX.Messaging.filters) {
-        for (const storedFolder of filter.folders) {
-          let folderParam;
-          if (typeof(storedFolder) === "string") {
-            //  Filters pre TB 121
-            folderParam = {
-              accountId: filter.accountId,
-              path: storedFolder,
-            };
-          } else {
-            //  Filters TB 121
-            folderParam = storedFolder.mailFolderId;
-          }
-    
-          let mailFolderInfo = {};
-          try {
-            mailFolderInfo = await browser.folders.getFolderInfo(folder);
-          } catch (err) {
-            //console.debug("Filter error: " + err);
-            //console.debug("Filter error: " + JSON.stringify(folder));
-    
-            //  Get all accounts
-            SysTrayX.Messaging.accounts = await browser.accounts.list();
-    
-            // Check the filters for the accounts
-            SysTrayX.Messaging.accountFilterCheck();
-          }
-
-          if (mailFolderInfo.unreadMessageCount !== undefined) {
-            unreadCount = unreadCount + mailFolderInfo.unreadMessageCount;
-          }
-        }
-      }
+      const totals = await getFolderCountTotals(folder, folderInfo);
+      unreadCount = totals.unread;
     }
 
     //console.debug("sendMailCount Unread: " + unreadCount);
     //console.debug("sendMailCount New: " + newCount);
     
-    SysTrayX.Link.postSysTrayXMessage( { mailCount: { unread: unreadCount, new: newCount } } );
+    publishMailCount(unreadCount, newCount);
   }
 };
@@ -10,6 +10,9 @@ SysTrayX.SaveOptions = {
   start: async function (e) {
     e.preventDefault();
 
+    //  Collect all preferences first, they are stored in one go
+    let prefs = {};
+
     //
     // Save accounts and filters
     //
@@ -49,7 +52,7 @@ SysTrayX.SaveOptions = {
 
     console.debug("Saving filters: " + JSON.stringify(filters));
 
-    await storage().set({
+    Object.assign(prefs, {
       filters: filters,
     });
 
@@ -57,7 +60,7 @@ SysTrayX.SaveOptions = {
     //  Save debug state
     //
     const debug = document.querySelector('input[name="debug"]').checked;
-    await storage().set({
+    Object.assign(prefs, {
       debug: `${debug}`,
     });
 
@@ -69,7 +72,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store minimize preferences
-    await storage().set({
+    Object.assign(prefs, {
       minimizeType: minimizeType,
     });
 
@@ -81,7 +84,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store minimize icon preferences
-    await storage().set({
+    Object.assign(prefs, {
       minimizeIconType: minimizeIconType,
     });
 
@@ -93,7 +96,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store close preferences
-    await storage().set({
+    Object.assign(prefs, {
       closeType: closeType,
     });
 
@@ -103,7 +106,7 @@ SysTrayX.SaveOptions = {
     const startupType = document.querySelector(
       'input[name="startupType"]:checked'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       startupType: startupType,
     });
 
@@ -113,7 +116,7 @@ SysTrayX.SaveOptions = {
     const windowPosCor = document.querySelector(
       'input[name="positionsCorrection"]'
     ).checked;
-    await storage().set({
+    Object.assign(prefs, {
       windowPosCor: `${windowPosCor}`,
     });
 
@@ -123,7 +126,7 @@ SysTrayX.SaveOptions = {
     const windowPosCorType = document.querySelector(
       'input[name="positionsCorrectionType"]:checked'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       windowPosCorType: windowPosCorType,
     });
 
@@ -133,7 +136,7 @@ SysTrayX.SaveOptions = {
     const restorePositions = document.querySelector(
       'input[name="restorePositions"]'
     ).checked;
-    await storage().set({
+    Object.assign(prefs, {
       restorePositions: `${restorePositions}`,
     });
 
@@ -145,7 +148,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store default icon type
-    await storage().set({
+    Object.assign(prefs, {
       defaultIconType: defaultIconType,
     });
 
@@ -156,7 +159,7 @@ SysTrayX.SaveOptions = {
     );
 
     //  Store default icon (base64)
-    await storage().set({
+    Object.assign(prefs, {
       defaultIconMime: defaultIconMime,
       defaultIcon: defaultIconBase64,
     });
@@ -167,7 +170,7 @@ SysTrayX.SaveOptions = {
     let hideDefaultIcon = document.querySelector(
       'input[name="hideDefaultIcon"]'
     ).checked;
-    await storage().set({
+    Object.assign(prefs, {
       hideDefaultIcon: `${hideDefaultIcon}`,
     });
 
@@ -179,7 +182,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store icon type
-    await storage().set({
+    Object.assign(prefs, {
       iconType: iconType,
     });
 
@@ -188,7 +191,7 @@ SysTrayX.SaveOptions = {
     const iconMime = iconDiv.getAttribute("data-icon-mime");
 
     //  Store icon (base64)
-    await storage().set({
+    Object.assign(prefs, {
       iconMime: iconMime,
       icon: iconBase64,
     });
@@ -199,7 +202,7 @@ SysTrayX.SaveOptions = {
     const invertIcon = document.querySelector('input[name="invertIcon"]').checked;
 
     //  Store invert icon preferences
-    await storage().set({
+    Object.assign(prefs, {
       invertIcon: `${invertIcon}`,
     });
 
@@ -209,7 +212,7 @@ SysTrayX.SaveOptions = {
     const showNumber = document.querySelector(
       'input[name="showNumber"]'
     ).checked;
-    await storage().set({
+    Object.assign(prefs, {
       showNumber: `${showNumber}`,
     });
 
@@ -219,7 +222,7 @@ SysTrayX.SaveOptions = {
     const showNewIndicator = document.querySelector(
       'input[name="showNewIndicator"]'
     ).checked;
-    await storage().set({
+    Object.assign(prefs, {
       showNewIndicator: `${showNewIndicator}`,
     });
 
@@ -229,7 +232,7 @@ SysTrayX.SaveOptions = {
     const countType = document.querySelector(
       'input[name="countType"]:checked'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       countType: countType,
     });
 
@@ -239,15 +242,25 @@ SysTrayX.SaveOptions = {
     const startupDelay = document.querySelector(
       'input[name="startupDelay"]'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       startupDelay: startupDelay,
     });
 
+    //
+    //  Save mail count debounce window
+    //
+    const mailCountDebounce = document.querySelector(
+      'input[name="mailCountDebounce"]'
+    ).value;
+    Object.assign(prefs, {
+      mailCountDebounce: mailCountDebounce,
+    });
+
     //
     //  Save API count method state
     //
     const apiCountMethod = document.querySelector('input[name="apiCountMethod"]').checked;
-    await storage().set({
+    Object.assign(prefs, {
       apiCountMethod: `${apiCountMethod}`,
     });
 
@@ -255,7 +268,7 @@ SysTrayX.SaveOptions = {
     //  Save number color
     //
     let numberColor = document.querySelector('input[name="numberColor"]').value;
-    await storage().set({
+    Object.assign(prefs, {
       numberColor: `${numberColor}`,
     });
 
@@ -263,7 +276,7 @@ SysTrayX.SaveOptions = {
     //  Save number size
     //
     const numberSize = document.querySelector('input[name="numberSize"]').value;
-    await storage().set({
+    Object.assign(prefs, {
       numberSize: numberSize,
     });
 
@@ -273,7 +286,7 @@ SysTrayX.SaveOptions = {
     const numberAlignment = document.querySelector(
       'select[name="numberAlignment"]'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       numberAlignment: numberAlignment,
     });
 
@@ -292,7 +305,7 @@ SysTrayX.SaveOptions = {
     const numberMarginBottom = document.querySelector(
       'input[name="numberMarginBottom"]'
     ).value;
-    await storage().set({
+    Object.assign(prefs, {
       numberMargins: {
         left: numberMarginLeft,
         top: numberMarginTop,
@@ -309,7 +322,7 @@ SysTrayX.SaveOptions = {
     ).value;
 
     //  Store neew indicator type
-    await storage().set({
+    Object.assign(prefs, {
       newIndicatorType: newIndicatorType,
     });
 
@@ -318,7 +331,7 @@ SysTrayX.SaveOptions = {
     //
     let newShadeColor = document.querySelector('input[name="newShadeColor"]').value;
 
-    await storage().set({
+    Object.assign(prefs, {
       newShadeColor: `${newShadeColor}`,
     });
 
@@ -336,7 +349,7 @@ SysTrayX.SaveOptions = {
     const closeAppArgs = closeAppArgsInput.value;
 
     //  Store launch parameters
-    await storage().set({
+    Object.assign(prefs, {
       startApp: startApp,
       startAppArgs: startAppArgs,
       closeApp: closeApp,
@@ -350,15 +363,30 @@ SysTrayX.SaveOptions = {
     const showHideShortcut = showHideShortcutInput.value;
 
     //  Store show / hide shortcut
-    await storage().set({
+    Object.assign(prefs, {
       showHideShortcut: showHideShortcut,
     });
 
-    //  Mark add-on preferences changed
-    await storage().set({
-      addonprefchanged: true,
+    //
+    //  Write only the changed keys, in a single set so background.js
+    //  handles the whole change set at once
+    //
+    const stored = await storage().get(Object.keys(prefs));
+
+    let changed = {};
+    Object.keys(prefs).forEach((key) => {
+      if (JSON.stringify(stored[key]) !== JSON.stringify(prefs[key])) {
+        changed[key] = prefs[key];
+      }
     });
 
+    if (Object.keys(changed).length > 0) {
+      //  Mark add-on preferences changed
+      changed.addonprefchanged = true;
+
+      await storage().set(changed);
+    }
+
     //    const inUse = await browser.storage.sync.getBytesInUse();
     //    console.log("Storage in use: " + inUse);
   },
@@ -566,6 +594,16 @@ SysTrayX.RestoreOptions = {
         SysTrayX.RestoreOptions.ontartupDelayError
       );
 
+    //
+    //  Restore mail count debounce window
+    //
+    await storage()
+      .get("mailCountDebounce")
+      .then(
+        SysTrayX.RestoreOptions.setMailCountDebounce,
+        SysTrayX.RestoreOptions.onMailCountDebounceError
+      );
+
     //
     //  Restore API count method state
     //
@@ -1061,6 +1099,21 @@ SysTrayX.RestoreOptions = {
     console.log(`StartupDelay Error: ${error}`);
   },
 
+  //
+  //  Restore mail count debounce window
+  //
+  setMailCountDebounce: function (result) {
+    const mailCountDebounce =
+      result.mailCountDebounce !== undefined ? result.mailCountDebounce : "250";
+
+    const input = document.querySelector(`input[name="mailCountDebounce"]`);
+    input.value = mailCountDebounce;
+  },
+
+  onMailCountDebounceError: function (error) {
+    console.log(`MailCountDebounce Error: ${error}`);
+  },
+
   //
   //  Restore API count method state callbacks
   //
@@ -1462,6 +1515,11 @@ SysTrayX.StorageChanged = {
           startupDelay: changes[item].newValue,
         });
       }
+      if (item === "mailCountDebounce") {
+        SysTrayX.RestoreOptions.setMailCountDebounce({
+          mailCountDebounce: changes[item].newValue,
+        });
+      }
       if (item === "apiCountMethod") {
         SysTrayX.RestoreOptions.setApiCountMethod({
           apiCountMethod: changes[item].newValue,